@@ -0,0 +1,20 @@
+#pragma once
+
+#include <memory>  // addressof
+
+// When an iterator's `reference` type is a proxy (for example
+// `std::pair<const Key&, T&>`) rather than a true reference, `operator*`
+// returns a prvalue, and so `operator->` can't return `std::addressof(*(*this))`;
+// that would be the address of a temporary.
+//
+// Instead, `operator->` should return an `arrow_proxy` holding the proxy
+// reference by value. [over.ref]p1: The language applies `->` again to the
+// result of a user-defined `operator->`, so `it->first` ends up meaning
+// `arrow_proxy{*it}.operator->()->first`, which is exactly what we want.
+//
+template<class Reference>
+struct arrow_proxy {
+    Reference r;
+
+    Reference* operator->() { return std::addressof(r); }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>  // min
+#include <chrono>  // duration, steady_clock
+#include <cstdio>  // printf
+#include <latch>  // latch
+#include <thread>  // hardware_concurrency, thread
+#include <vector>  // vector
+
+// The programs in this directory are benchmarks for the concurrent
+// containers and algorithms, each a single translation unit. Build one from
+// the top of the repository with, for example,
+//
+//   c++ -std=c++20 -O2 -DNDEBUG -pthread -I. bench/work-stealing-pool.cpp
+//
+// and run it with no arguments. Each prints a table to stdout. Times are
+// wall-clock times, the best of a few runs; take them on an otherwise idle
+// machine, and beware of numbers for more threads than it has cores.
+//
+
+// Seconds taken by the fastest of `runs` calls of `f()`. `setup()` runs,
+// untimed, before each.
+//
+template<class Setup, class F>
+double best_of(int runs, Setup setup, F f) {
+    double best = 1e300;
+    for (int i = 0; i < runs; ++i) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+template<class F>
+double best_of(int runs, F f) {
+    return best_of(runs, [] {}, f);
+}
+
+// Seconds from the moment `threads` threads are all ready to run
+// `f(index)` until the last of them is done.
+//
+template<class F>
+double time_threads(unsigned threads, F f) {
+    std::latch ready(threads + 1);
+    std::vector<std::thread> ts;
+    ts.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        ts.emplace_back([&, i] {
+            ready.arrive_and_wait();
+            f(i);
+        });
+    }
+    ready.arrive_and_wait();
+    auto start = std::chrono::steady_clock::now();
+    for (std::thread& t : ts) {
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// 1, 2, 4, ... and `max` itself.
+//
+inline std::vector<unsigned> thread_counts(unsigned max) {
+    std::vector<unsigned> counts;
+    for (unsigned n = 1; n < max; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(max);
+    return counts;
+}
+
+inline unsigned hardware_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return (n == 0) ? 1 : n;
+}
@@ -0,0 +1,77 @@
+#include <cstddef>  // size_t
+#include <cstdio>  // printf
+#include <cstdlib>  // strtoul
+#include <mutex>  // lock_guard, mutex
+#include <queue>  // queue
+#include <stack>  // stack
+
+#include "bench.h"
+#include "lock-free-list.h"
+
+// Throughput of `lock_free_stack` and `lock_free_queue` against a
+// `std::stack` and a `std::queue` guarded by one `std::mutex`, at 1 to 64
+// threads. Each thread alternately pushes and pops, so the container stays
+// about as full as it starts; the total number of operations is the same
+// at every thread count.
+//
+//   lock-free-list [operations]
+//
+
+template<class C>
+class locked {
+  public:
+    void push(long x) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        c_.push(x);
+    }
+
+    bool try_pop(long& out) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (c_.empty()) {
+            return false;
+        }
+        if constexpr (requires { c_.top(); }) {
+            out = c_.top();
+        } else {
+            out = c_.front();
+        }
+        c_.pop();
+        return true;
+    }
+
+  private:
+    std::mutex mutex_;
+    C c_;
+};
+
+// Millions of operations (pushes plus pops) per second.
+//
+template<class C>
+double throughput(unsigned threads, std::size_t operations) {
+    C c;
+    for (long i = 0; i < 1024; ++i) {
+        c.push(i);
+    }
+    std::size_t pairs = operations / 2 / threads;
+    double t = time_threads(threads, [&](unsigned index) {
+        long x = long(index);
+        for (std::size_t i = 0; i < pairs; ++i) {
+            c.push(x);
+            c.try_pop(x);
+        }
+    });
+    return double(2 * pairs * threads) / t / 1e6;
+}
+
+int main(int argc, char **argv) {
+    std::size_t operations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10'000'000;
+    std::printf("%zu pushes and pops in all, Mops/s\n", operations);
+    std::printf("%7s %16s %16s %16s %16s\n", "threads", "lock_free_stack", "mutex+std::stack", "lock_free_queue", "mutex+std::queue");
+    for (unsigned threads : thread_counts(64)) {
+        std::printf("%7u %16.2f %16.2f %16.2f %16.2f\n", threads,
+                    throughput<lock_free_stack<long>>(threads, operations),
+                    throughput<locked<std::stack<long>>>(threads, operations),
+                    throughput<lock_free_queue<long>>(threads, operations),
+                    throughput<locked<std::queue<long>>>(threads, operations));
+    }
+}
@@ -0,0 +1,91 @@
+#include <atomic>  // atomic, memory_order
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <cstdio>  // printf
+#include <cstdlib>  // strtoul
+#include <mutex>  // lock_guard, mutex
+#include <optional>  // optional
+#include <unordered_map>  // unordered_map
+
+#include "bench.h"
+#include "sharded-hash-map.h"
+
+// Throughput of `sharded_hash_map` against a `std::unordered_map` guarded
+// by one `std::mutex`, at 1 to 64 threads all hammering the same map, as
+// a session cache is. The keys are drawn uniformly from a fixed set, about
+// half of which are in the map at any time. Each operation is a lookup, or
+// (with the given probability) an insert-or-assign or an erase.
+//
+//   sharded-hash-map [operations]
+//
+
+class locked_unordered_map {
+  public:
+    std::optional<long> get(long k) const {
+        std::lock_guard<std::mutex> lk(mutex_);
+        auto it = map_.find(k);
+        return (it == map_.end()) ? std::nullopt : std::optional<long>(it->second);
+    }
+
+    void insert_or_assign(long k, long v) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        map_.insert_or_assign(k, v);
+    }
+
+    void erase(long k) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        map_.erase(k);
+    }
+
+  private:
+    mutable std::mutex mutex_;
+    std::unordered_map<long, long> map_;
+};
+
+constexpr long key_count = 1 << 16;
+
+// Millions of operations per second, where `writes` out of every 100
+// operations modify the map.
+//
+template<class Map>
+double throughput(unsigned threads, std::size_t operations, unsigned writes) {
+    Map map;
+    for (long k = 0; k < key_count; k += 2) {
+        map.insert_or_assign(k, k);
+    }
+    std::size_t per_thread = operations / threads;
+    std::atomic<long> hits = 0;
+    double t = time_threads(threads, [&](unsigned index) {
+        std::uint64_t rng = 0x9e3779b97f4a7c15ULL * (index + 1);
+        long found = 0;
+        for (std::size_t i = 0; i < per_thread; ++i) {
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            long k = long(rng % key_count);
+            unsigned dice = unsigned(rng >> 32) % 100;
+            if (dice >= writes) {
+                found += map.get(k).has_value();
+            } else if (dice % 2 == 0) {
+                map.insert_or_assign(k, long(i));
+            } else {
+                map.erase(k);
+            }
+        }
+        hits.fetch_add(found, std::memory_order_relaxed);
+    });
+    return double(per_thread * threads) / t / 1e6;
+}
+
+int main(int argc, char **argv) {
+    std::size_t operations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10'000'000;
+    std::printf("%zu operations in all, on %ld keys, Mops/s\n", operations, key_count);
+    std::printf("%7s %8s %18s %24s\n", "threads", "writes", "sharded_hash_map", "mutex+std::unordered_map");
+    for (unsigned writes : {10u, 50u}) {
+        for (unsigned threads : thread_counts(64)) {
+            std::printf("%7u %7u%% %18.2f %24.2f\n", threads, writes,
+                        throughput<sharded_hash_map<long, long>>(threads, operations, writes),
+                        throughput<locked_unordered_map>(threads, operations, writes));
+        }
+    }
+}
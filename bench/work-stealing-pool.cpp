@@ -0,0 +1,125 @@
+#include <algorithm>  // ranges::sort
+#include <cstddef>  // size_t
+#include <cstdio>  // printf, snprintf
+#include <cstdlib>  // strtoul
+#include <functional>  // ranges::less
+#include <future>  // async, future, launch
+#include <memory>  // make_unique_for_overwrite
+#include <random>  // mt19937_64, uniform_int_distribution
+#include <vector>  // vector
+
+#include "bench.h"
+#include "parallel-sort.h"
+#include "parallel.h"
+#include "work-stealing-pool.h"
+
+// The cost of one `fork_join` on a `work_stealing_pool`, against a plain
+// function call and against `std::async`, and then how a recursive
+// parallel merge sort and a parallel reduction scale from one worker to
+// one per hardware thread.
+//
+//   work-stealing-pool [elements [max-workers]]
+//
+
+static std::size_t volatile sink;
+
+static std::size_t leaves_sequential(int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    return leaves_sequential(depth - 1) + leaves_sequential(depth - 1);
+}
+
+static std::size_t leaves_forked(work_stealing_pool& pool, int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    std::size_t a, b;
+    pool.fork_join([&] { a = leaves_forked(pool, depth - 1); }, [&] { b = leaves_forked(pool, depth - 1); });
+    return a + b;
+}
+
+static std::size_t leaves_async(int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    std::future<std::size_t> a = std::async(std::launch::async, leaves_async, depth - 1);
+    std::size_t b = leaves_async(depth - 1);
+    return a.get() + b;
+}
+
+static void fork_join_overhead(unsigned max_workers) {
+    constexpr int depth = 20;
+    constexpr int async_depth = 10;
+    double forks = double((std::size_t(1) << depth) - 1);
+    double asyncs = double((std::size_t(1) << async_depth) - 1);
+
+    std::printf("fork/join overhead (a binary tree of 2^%d empty leaf tasks)\n", depth);
+    double t = best_of(5, [] { sink = leaves_sequential(depth); });
+    std::printf("  %-28s %8.1f ns per call\n", "plain recursion", t / forks * 1e9);
+    for (unsigned threads : {1u, max_workers}) {
+        work_stealing_pool pool(threads);
+        t = best_of(5, [&] { pool.run([&] { sink = leaves_forked(pool, depth); }); });
+        char label[32];
+        std::snprintf(label, sizeof(label), "fork_join, %u worker%s", threads, (threads == 1) ? "" : "s");
+        std::printf("  %-28s %8.1f ns per fork\n", label, t / forks * 1e9);
+        if (max_workers == 1) {
+            break;
+        }
+    }
+    t = best_of(3, [] { sink = leaves_async(async_depth); });
+    std::printf("  %-28s %8.1f ns per task (2^%d leaves)\n\n", "std::async", t / asyncs * 1e9, async_depth);
+}
+
+static void scaling(std::size_t n, unsigned max_workers) {
+    std::vector<long> data(n);
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<long> dist;
+    for (long& x : data) {
+        x = dist(rng);
+    }
+    std::vector<long> v;
+    auto buf = std::make_unique_for_overwrite<long[]>(n);
+
+    std::printf("scaling, %zu random longs\n", n);
+    double t_sort_seq = best_of(3, [&] { v = data; }, [&] { std::ranges::sort(v); });
+    std::printf("  std::ranges::sort on one thread: %.1f ms\n", t_sort_seq * 1e3);
+    std::printf("  %7s %10s %8s %10s %8s\n", "workers", "sort ms", "speedup", "reduce ms", "speedup");
+
+    double t_sort_1 = 0;
+    double t_reduce_1 = 0;
+    for (unsigned threads : thread_counts(max_workers)) {
+        work_stealing_pool pool(threads);
+        std::ranges::less less;
+        double t_sort = best_of(3, [&] { v = data; }, [&] {
+            pool.run([&] { parallel_merge_sort(pool, v.begin(), v.end(), buf.get(), less, false); });
+        });
+
+        auto body = [](auto& piece, std::size_t) {
+            long sum = 0;
+            for (long x : piece) {
+                sum += x;
+            }
+            return sum;
+        };
+        auto join = [](long a, long b) { return a + b; };
+        unsigned pieces = (threads == 1) ? 1 : 4 * threads;
+        double t_reduce = best_of(5, [&] {
+            sink = std::size_t(parallel_split_invoke(pool, make_blocked_range(data, 1), body, join, pieces));
+        });
+
+        if (threads == 1) {
+            t_sort_1 = t_sort;
+            t_reduce_1 = t_reduce;
+        }
+        std::printf("  %7u %10.1f %7.2fx %10.2f %7.2fx\n", threads,
+                    t_sort * 1e3, t_sort_1 / t_sort, t_reduce * 1e3, t_reduce_1 / t_reduce);
+    }
+}
+
+int main(int argc, char **argv) {
+    std::size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10'000'000;
+    unsigned max_workers = (argc > 2) ? unsigned(std::strtoul(argv[2], nullptr, 10)) : hardware_threads();
+    fork_join_overhead(max_workers);
+    scaling(n, max_workers);
+}
@@ -0,0 +1,449 @@
+#pragma once
+
+#include <bit>  // countr_zero, popcount
+#include <climits>  // CHAR_BIT
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint64_t
+#include <initializer_list>  // initializer_list
+#include <iterator>  // random_access_iterator, random_access_iterator_tag
+#include <stdexcept>  // out_of_range
+#include <type_traits>  // basic_common_reference, conditional_t, is_const_v, remove_cv_t
+#include <utility>  // swap
+#include <vector>  // vector
+
+#include "reversible-container.h"
+
+class bit_reference;
+
+template<
+    class QualifiedType,
+    class UnqualifiedType = std::remove_cv_t<QualifiedType>
+> struct BitVectorIterator;
+
+// `bit_reference` is the proxy `reference` type of `BitVectorIterator<bool>`:
+// a pointer to a word plus a mask selecting one bit of it.
+//
+// [iterator.concept.writable]: For `BitVectorIterator<bool>` to be
+// `std::indirectly_writable`, the expression `*it = v` must work even when
+// `*it` is a const prvalue. So, unlike `std::vector<bool>::reference` before
+// C++23, `bit_reference` has const-qualified assignment operators.
+// (The assignments write through the pointer, not to the proxy itself.)
+//
+// [iterator.concept.readable]: `std::indirectly_readable` also requires a
+// common reference between `bit_reference&&` and `bool&`; the
+// `std::basic_common_reference` specializations below make that `bool`.
+//
+class bit_reference {
+  public:
+    using word_type = std::uint64_t;
+
+    bit_reference(const bit_reference&) = default;
+
+    operator bool() const noexcept { return (*word_ & mask_) != 0; }
+    bool operator~() const noexcept { return !bool(*this); }
+
+    const bit_reference& operator=(bool value) const noexcept {
+        if (value) {
+            *word_ |= mask_;
+        } else {
+            *word_ &= ~mask_;
+        }
+        return *this;
+    }
+
+    const bit_reference& operator=(const bit_reference& other) const noexcept {
+        return *this = bool(other);
+    }
+
+    void flip() const noexcept { *word_ ^= mask_; }
+
+    // [iterator.cust.swap]: `std::ranges::iter_swap` and `std::swap` on two
+    // proxies must swap the referenced bits, not the proxies.
+    //
+    friend void swap(bit_reference a, bit_reference b) noexcept {
+        bool tmp = a;
+        a = bool(b);
+        b = tmp;
+    }
+    friend void swap(bit_reference a, bool& b) noexcept {
+        bool tmp = a;
+        a = b;
+        b = tmp;
+    }
+    friend void swap(bool& a, bit_reference b) noexcept { swap(b, a); }
+
+  private:
+    template<class, class> friend struct BitVectorIterator;
+    friend class bit_vector;
+
+    explicit bit_reference(word_type *word, word_type mask) : word_(word), mask_(mask) {}
+
+    word_type *word_;
+    word_type mask_;
+};
+
+template<template<class> class TQual, template<class> class UQual>
+struct std::basic_common_reference<bit_reference, bool, TQual, UQual> { using type = bool; };
+
+template<template<class> class TQual, template<class> class UQual>
+struct std::basic_common_reference<bool, bit_reference, TQual, UQual> { using type = bool; };
+
+// `bit_vector` is a sequence of `bool` packed 64 to a word: the same idea as
+// `std::vector<bool>`, but with a proxy reference type that satisfies the
+// C++20 iterator concepts, so that `std::ranges` algorithms accept it.
+//
+// For the common bulk algorithms `fill`, `count`, `find`, and `copy`,
+// `BitVectorIterator` provides overloads (found by argument-dependent lookup)
+// that operate a whole word at a time instead of a bit at a time. Call them
+// unqualified, or with `using std::fill;` in scope, to pick them up: we
+// aren't allowed to add overloads to namespace `std`, so a qualified call to
+// `std::fill` will still go through the generic bit-at-a-time algorithm.
+//
+class bit_vector : public reversible_container<bit_vector> {
+  public:
+    using word_type = std::uint64_t;
+    using value_type = bool;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = bit_reference;
+    using const_reference = bool;
+    using iterator = BitVectorIterator<bool>;
+    using const_iterator = BitVectorIterator<const bool>;
+    using reverse_iterator = reverse_iterator_t<iterator>;
+    using const_reverse_iterator = reverse_iterator_t<const_iterator>;
+
+    static constexpr size_type bits_per_word = sizeof(word_type) * CHAR_BIT;
+
+    bit_vector() = default;
+    explicit bit_vector(size_type n, bool value = false) { resize(n, value); }
+    bit_vector(std::initializer_list<bool> il) {
+        reserve(il.size());
+        for (bool b : il) {
+            push_back(b);
+        }
+    }
+
+    inline iterator begin() noexcept;
+    inline const_iterator begin() const noexcept;
+    inline const_iterator cbegin() const noexcept;
+    inline iterator end() noexcept;
+    inline const_iterator end() const noexcept;
+    inline const_iterator cend() const noexcept;
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    size_type capacity() const noexcept { return words_.capacity() * bits_per_word; }
+    void reserve(size_type n) { words_.reserve(words_for(n)); }
+    void shrink_to_fit() { words_.shrink_to_fit(); }
+
+    reference operator[](size_type i) { return reference(&words_[i / bits_per_word], mask(i)); }
+    const_reference operator[](size_type i) const { return (words_[i / bits_per_word] & mask(i)) != 0; }
+
+    reference at(size_type i) {
+        if (i >= size_) {
+            throw std::out_of_range("bit_vector::at");
+        }
+        return (*this)[i];
+    }
+    const_reference at(size_type i) const {
+        if (i >= size_) {
+            throw std::out_of_range("bit_vector::at");
+        }
+        return (*this)[i];
+    }
+
+    reference front() { return (*this)[0]; }
+    const_reference front() const { return (*this)[0]; }
+    reference back() { return (*this)[size_ - 1]; }
+    const_reference back() const { return (*this)[size_ - 1]; }
+
+    void push_back(bool value) {
+        if (size_ % bits_per_word == 0) {
+            words_.push_back(0);
+        }
+        size_ += 1;
+        back() = value;
+    }
+
+    void pop_back() {
+        back() = false;
+        size_ -= 1;
+        if (size_ % bits_per_word == 0) {
+            words_.pop_back();
+        }
+    }
+
+    // New bits are set a word at a time (via `fill`), not a bit at a time.
+    //
+    inline void resize(size_type n, bool value = false);
+
+    void clear() noexcept {
+        words_.clear();
+        size_ = 0;
+    }
+
+    void flip() noexcept {
+        for (word_type& w : words_) {
+            w = ~w;
+        }
+        clear_tail();
+    }
+
+    void swap(bit_vector& other) noexcept {
+        words_.swap(other.words_);
+        std::swap(size_, other.size_);
+    }
+    friend void swap(bit_vector& a, bit_vector& b) noexcept { a.swap(b); }
+
+    // Invariant: the bits of the last word beyond `size()` are always zero,
+    // so equality can compare whole words.
+    //
+    friend bool operator==(const bit_vector& a, const bit_vector& b) noexcept {
+        return a.size_ == b.size_ && a.words_ == b.words_;
+    }
+
+    const word_type *data() const noexcept { return words_.data(); }
+    word_type *data() noexcept { return words_.data(); }
+
+  private:
+    static size_type words_for(size_type n) { return (n + bits_per_word - 1) / bits_per_word; }
+    static word_type mask(size_type i) { return word_type(1) << (i % bits_per_word); }
+
+    void clear_tail() noexcept {
+        if (size_ % bits_per_word != 0) {
+            words_.back() &= ~(~word_type(0) << (size_ % bits_per_word));
+        }
+    }
+
+    std::vector<word_type> words_;
+    size_type size_ = 0;
+};
+
+// `BitVectorIterator<bool>` is a mutable random-access iterator whose
+// `reference` is `bit_reference`; `BitVectorIterator<const bool>` is a
+// constant iterator whose `reference` is plain `bool`. Neither has an
+// `operator->`, since there is no `bool` object to point to.
+//
+// Its state is a pointer to the current word plus a bit offset within
+// that word, so `*it` is a shift and a mask, and `it += n` is two
+// arithmetic operations.
+//
+template<class QualifiedType,
+         class UnqualifiedType /* = std::remove_cv_t<QualifiedType> */>
+struct BitVectorIterator
+{
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = UnqualifiedType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::conditional_t<std::is_const_v<QualifiedType>, bool, bit_reference>;
+
+    BitVectorIterator() {}
+
+    friend class bit_vector;
+    template<class, class> friend struct BitVectorIterator;
+  private:
+    using word_type = std::conditional_t<std::is_const_v<QualifiedType>, const std::uint64_t, std::uint64_t>;
+    static constexpr unsigned bits_per_word = 64;
+
+    explicit BitVectorIterator(word_type *word, unsigned offset) : word_(word), offset_(offset) {}
+  public:
+
+    BitVectorIterator(BitVectorIterator const&) = default;
+    BitVectorIterator& operator=(BitVectorIterator const&) = default;
+    BitVectorIterator(BitVectorIterator&&) noexcept = default;
+    BitVectorIterator& operator=(BitVectorIterator&&) = default;
+    ~BitVectorIterator() = default;
+
+    BitVectorIterator operator++(int) {
+        BitVectorIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    BitVectorIterator operator--(int) {
+        BitVectorIterator tmp = *this;
+        --(*this);
+        return tmp;
+    }
+
+    BitVectorIterator& operator++() {
+        if (++offset_ == bits_per_word) {
+            offset_ = 0;
+            ++word_;
+        }
+        return *this;
+    }
+
+    BitVectorIterator& operator--() {
+        if (offset_-- == 0) {
+            offset_ = bits_per_word - 1;
+            --word_;
+        }
+        return *this;
+    }
+
+    BitVectorIterator& operator+=(difference_type n) {
+        difference_type bit = difference_type(offset_) + n;
+        difference_type words = (bit >= 0) ? bit / difference_type(bits_per_word) : -((difference_type(bits_per_word) - 1 - bit) / difference_type(bits_per_word));
+        word_ += words;
+        offset_ = static_cast<unsigned>(bit - words * difference_type(bits_per_word));
+        return *this;
+    }
+    BitVectorIterator& operator-=(difference_type n) { return *this += -n; }
+    BitVectorIterator operator+(difference_type n) const { BitVectorIterator tmp = *this; return tmp += n; }
+    BitVectorIterator operator-(difference_type n) const { BitVectorIterator tmp = *this; return tmp -= n; }
+    friend BitVectorIterator operator+(difference_type n, const BitVectorIterator& it) { return it + n; }
+
+    template<class QT>
+    difference_type operator-(BitVectorIterator<QT> const& other) const {
+        return (word_ - other.word_) * difference_type(bits_per_word) + difference_type(offset_) - difference_type(other.offset_);
+    }
+
+    reference operator*() const {
+        if constexpr (std::is_const_v<QualifiedType>) {
+            return (*word_ >> offset_) & 1;
+        } else {
+            return reference(word_, std::uint64_t(1) << offset_);
+        }
+    }
+
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    friend void swap(BitVectorIterator& a, BitVectorIterator& b) {
+        std::swap(a.word_, b.word_);
+        std::swap(a.offset_, b.offset_);
+    }
+
+    template<class QT>
+    bool operator==(BitVectorIterator<QT> const& other) const { return word_ == other.word_ && offset_ == other.offset_; }
+    template<class QT>
+    bool operator!=(BitVectorIterator<QT> const& other) const { return !(*this == other); }
+    template<class QT>
+    bool operator<(BitVectorIterator<QT> const& other) const { return (*this - other) < 0; }
+    template<class QT>
+    bool operator>(BitVectorIterator<QT> const& other) const { return other < *this; }
+    template<class QT>
+    bool operator<=(BitVectorIterator<QT> const& other) const { return !(other < *this); }
+    template<class QT>
+    bool operator>=(BitVectorIterator<QT> const& other) const { return !(*this < other); }
+
+    operator BitVectorIterator<const UnqualifiedType>() const {
+        return BitVectorIterator<const UnqualifiedType>(word_, offset_);
+    }
+
+    // Word-at-a-time versions of the standard algorithms. Each one handles
+    // the partial words at either end with a mask, and everything in between
+    // one full word per iteration.
+    //
+    friend void fill(BitVectorIterator first, BitVectorIterator last, bool value)
+        requires (!std::is_const_v<QualifiedType>)
+    {
+        std::uint64_t pattern = value ? ~std::uint64_t(0) : 0;
+        for_each_span(first, last, [&](word_type *w, std::uint64_t m) { *w = (*w & ~m) | (pattern & m); });
+    }
+
+    friend difference_type count(BitVectorIterator first, BitVectorIterator last, bool value) {
+        difference_type ones = 0;
+        for_each_span(first, last, [&](word_type *w, std::uint64_t m) { ones += std::popcount(*w & m); });
+        return value ? ones : (last - first) - ones;
+    }
+
+    friend BitVectorIterator find(BitVectorIterator first, BitVectorIterator last, bool value) {
+        std::uint64_t invert = value ? 0 : ~std::uint64_t(0);
+        while (first != last) {
+            unsigned n = (first.word_ == last.word_) ? last.offset_ - first.offset_ : bits_per_word - first.offset_;
+            std::uint64_t hits = ((*first.word_ ^ invert) >> first.offset_) & low_bits(n);
+            if (hits != 0) {
+                return first + std::countr_zero(hits);
+            }
+            first += n;
+        }
+        return last;
+    }
+
+    friend BitVectorIterator<bool> copy(BitVectorIterator first, BitVectorIterator last, BitVectorIterator<bool> out) {
+        difference_type n = last - first;
+        while (n >= difference_type(bits_per_word)) {
+            store(out, load(first, bits_per_word), bits_per_word);
+            first.word_ += 1;
+            out.word_ += 1;
+            n -= bits_per_word;
+        }
+        if (n > 0) {
+            store(out, load(first, unsigned(n)), unsigned(n));
+            out += n;
+        }
+        return out;
+    }
+
+  private:
+    static std::uint64_t low_bits(unsigned n) { return (n == bits_per_word) ? ~std::uint64_t(0) : (std::uint64_t(1) << n) - 1; }
+
+    // Calls `f(word, mask)` for each word overlapping [first, last),
+    // with `mask` selecting just the bits of that word inside the range.
+    //
+    template<class F>
+    static void for_each_span(BitVectorIterator first, BitVectorIterator last, F f) {
+        if (first.word_ == last.word_) {
+            if (first.offset_ != last.offset_) {
+                f(first.word_, low_bits(last.offset_ - first.offset_) << first.offset_);
+            }
+            return;
+        }
+        word_type *w = first.word_;
+        if (first.offset_ != 0) {
+            f(w++, ~std::uint64_t(0) << first.offset_);
+        }
+        for (; w != last.word_; ++w) {
+            f(w, ~std::uint64_t(0));
+        }
+        if (last.offset_ != 0) {
+            f(w, low_bits(last.offset_));
+        }
+    }
+
+    // Reads the `n` bits starting at `it` into the low bits of the result,
+    // touching the following word only if the bits actually extend into it.
+    //
+    static std::uint64_t load(BitVectorIterator it, unsigned n) {
+        std::uint64_t bits = it.word_[0] >> it.offset_;
+        if (it.offset_ != 0 && it.offset_ + n > bits_per_word) {
+            bits |= it.word_[1] << (bits_per_word - it.offset_);
+        }
+        return bits & low_bits(n);
+    }
+
+    static void store(BitVectorIterator<bool> it, std::uint64_t bits, unsigned n) {
+        std::uint64_t m = low_bits(n);
+        it.word_[0] = (it.word_[0] & ~(m << it.offset_)) | (bits << it.offset_);
+        if (it.offset_ != 0 && it.offset_ + n > bits_per_word) {
+            unsigned shift = bits_per_word - it.offset_;
+            it.word_[1] = (it.word_[1] & ~(m >> shift)) | (bits >> shift);
+        }
+    }
+
+    word_type *word_ = nullptr;
+    unsigned offset_ = 0;
+};
+
+inline bit_vector::iterator bit_vector::begin() noexcept { return iterator(words_.data(), 0); }
+inline bit_vector::const_iterator bit_vector::begin() const noexcept { return cbegin(); }
+inline bit_vector::const_iterator bit_vector::cbegin() const noexcept { return const_iterator(words_.data(), 0); }
+inline bit_vector::iterator bit_vector::end() noexcept { return begin() + difference_type(size_); }
+inline bit_vector::const_iterator bit_vector::end() const noexcept { return cend(); }
+inline bit_vector::const_iterator bit_vector::cend() const noexcept { return cbegin() + difference_type(size_); }
+
+inline void bit_vector::resize(size_type n, bool value) {
+    size_type old = size_;
+    words_.resize(words_for(n), 0);
+    size_ = n;
+    if (n > old) {
+        fill(begin() + difference_type(old), end(), value);
+    }
+    clear_tail();
+}
+
+static_assert(std::random_access_iterator<bit_vector::iterator>);
+static_assert(std::random_access_iterator<bit_vector::const_iterator>);
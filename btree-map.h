@@ -0,0 +1,626 @@
+#pragma once
+
+#include <algorithm>  // lower_bound, max, move, move_backward, upper_bound
+#include <cstddef>  // ptrdiff_t, size_t
+#include <functional>  // less
+#include <initializer_list>  // initializer_list
+#include <iterator>  // bidirectional_iterator, bidirectional_iterator_tag
+#include <memory>  // destroy_at, launder
+#include <new>  // placement new
+#include <stdexcept>  // out_of_range
+#include <type_traits>  // conditional_t, is_const_v, remove_cv_t
+#include <utility>  // forward, move, pair, swap
+
+#include "arrow-proxy.h"
+#include "pair-reference.h"
+#include "reversible-container.h"
+
+template<
+    class QualifiedMap,
+    class UnqualifiedMap = std::remove_cv_t<QualifiedMap>,
+    class Reference = pair_reference<
+        const typename UnqualifiedMap::key_type&,
+        std::conditional_t<
+            std::is_const_v<QualifiedMap>,
+            const typename UnqualifiedMap::mapped_type,
+            typename UnqualifiedMap::mapped_type
+        >&
+    >
+> struct BtreeMapIterator;
+
+// `btree_map` is an ordered map implemented as a B+tree. All the elements
+// live in the leaves, which are linked into a doubly linked list, so an
+// in-order scan visits each leaf exactly once and never touches an inner node.
+//
+// Node sizes are chosen from `sizeof(Key)` so that each node's key array
+// fills about `NodeBytes` bytes (by default, four 64-byte cache lines).
+// Within a leaf, keys and mapped values are stored in separate arrays, so a
+// search touches only the key cache lines; and since every node holds dozens
+// of elements, the per-element overhead is a small fraction of `std::map`'s
+// three pointers and a color bit.
+//
+// Unlike `std::map`, `insert` and `erase` invalidate all iterators, because
+// elements move between nodes as they split.
+//
+// `erase` removes a leaf once it becomes empty, but does not otherwise
+// rebalance; a workload that erases most of the elements can leave many
+// sparsely populated leaves behind.
+//
+template<class Key, class T, class Compare = std::less<Key>, std::size_t NodeBytes = 256>
+class btree_map : public reversible_container<btree_map<Key, T, Compare, NodeBytes>> {
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using key_compare = Compare;
+    using reference = pair_reference<const Key&, T&>;
+    using const_reference = pair_reference<const Key&, const T&>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = BtreeMapIterator<btree_map>;
+    using const_iterator = BtreeMapIterator<const btree_map>;
+    using reverse_iterator = reverse_iterator_t<iterator>;
+    using const_reverse_iterator = reverse_iterator_t<const_iterator>;
+
+    static constexpr std::size_t leaf_capacity = std::max<std::size_t>(8, NodeBytes / sizeof(Key));
+    static constexpr std::size_t inner_capacity = std::max<std::size_t>(4, NodeBytes / (sizeof(Key) + sizeof(void*)));
+
+    btree_map() = default;
+    explicit btree_map(const Compare& comp) : comp_(comp) {}
+
+    template<class InputIt>
+    btree_map(InputIt first, InputIt last, const Compare& comp = Compare()) : comp_(comp) {
+        insert(first, last);
+    }
+
+    btree_map(std::initializer_list<value_type> il, const Compare& comp = Compare())
+        : btree_map(il.begin(), il.end(), comp) {}
+
+    // Copying inserts the elements in ascending order, which takes the
+    // append fast path in `try_emplace` and produces completely full leaves.
+    //
+    btree_map(const btree_map& other) : comp_(other.comp_) {
+        for (auto&& kv : other) {
+            try_emplace(kv.first, kv.second);
+        }
+    }
+
+    btree_map(btree_map&& other) noexcept { swap(other); }
+
+    btree_map& operator=(btree_map other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~btree_map() { clear(); }
+
+    iterator begin() { return iterator(first_leaf_, 0); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(first_leaf_, 0); }
+    iterator end() { return iterator(last_leaf_, last_leaf_ ? last_leaf_->count : 0); }
+    const_iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(last_leaf_, last_leaf_ ? last_leaf_->count : 0); }
+
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    key_compare key_comp() const { return comp_; }
+
+    T& operator[](const Key& k) { return try_emplace(k).first->second; }
+    T& operator[](Key&& k) { return try_emplace(std::move(k)).first->second; }
+
+    T& at(const Key& k) {
+        auto it = find(k);
+        if (it == end()) {
+            throw std::out_of_range("btree_map::at");
+        }
+        return it->second;
+    }
+    const T& at(const Key& k) const {
+        auto it = find(k);
+        if (it == end()) {
+            throw std::out_of_range("btree_map::at");
+        }
+        return it->second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& kv) { return try_emplace(kv.first, kv.second); }
+    std::pair<iterator, bool> insert(value_type&& kv) { return try_emplace(std::move(kv.first), std::move(kv.second)); }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> il) { insert(il.begin(), il.end()); }
+
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        value_type kv(std::forward<Args>(args)...);
+        return try_emplace(std::move(kv.first), std::move(kv.second));
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> try_emplace(K&& k, Args&&... args) {
+        if (root_ == nullptr) {
+            root_ = first_leaf_ = last_leaf_ = new leaf_node;
+        }
+        path_type path;
+        int depth = 0;
+        leaf_node *leaf = descend(k, path, depth);
+        unsigned pos = leaf->lower_bound(k, comp_);
+        if (pos != leaf->count && !comp_(k, leaf->key(pos))) {
+            return {iterator(leaf, pos), false};
+        }
+        leaf->insert_at(pos, std::forward<K>(k), std::forward<Args>(args)...);
+        size_ += 1;
+        if (leaf->count > leaf_capacity) {
+            // The append fast path: when the new element went at the very end
+            // of the last leaf, we're probably being fed keys in ascending order.
+            // Leave the old leaf full and start a new one, rather than leaving
+            // a trail of half-empty leaves behind us.
+            //
+            unsigned split = (leaf == last_leaf_ && pos == leaf_capacity) ? leaf_capacity : (leaf_capacity + 1) / 2;
+            leaf_node *right = split_leaf(leaf, split);
+            insert_into_parent(path, depth, Key(right->key(0)), right);
+            if (pos >= split) {
+                leaf = right;
+                pos -= split;
+            }
+        }
+        return {iterator(leaf, pos), true};
+    }
+
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const Key& k, M&& obj) {
+        auto result = try_emplace(k, std::forward<M>(obj));
+        if (!result.second) {
+            result.first->second = std::forward<M>(obj);
+        }
+        return result;
+    }
+
+    iterator erase(const_iterator pos) {
+        path_type path;
+        int depth = 0;
+        leaf_node *leaf = descend(pos->first, path, depth);
+        return erase_at(path, depth, leaf, pos.idx_);
+    }
+    iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        // Erasing may free the leaf that `last` points into, so count first.
+        auto n = std::distance(first, last);
+        iterator it(position{first.leaf_, first.idx_});
+        for (; n != 0; --n) {
+            it = erase(it);
+        }
+        return it;
+    }
+
+    size_type erase(const Key& k) {
+        if (root_ == nullptr) {
+            return 0;
+        }
+        path_type path;
+        int depth = 0;
+        leaf_node *leaf = descend(k, path, depth);
+        unsigned pos = leaf->lower_bound(k, comp_);
+        if (pos == leaf->count || comp_(k, leaf->key(pos))) {
+            return 0;
+        }
+        erase_at(path, depth, leaf, pos);
+        return 1;
+    }
+
+    void clear() noexcept {
+        if (root_ != nullptr) {
+            destroy_subtree(root_);
+        }
+        root_ = nullptr;
+        first_leaf_ = last_leaf_ = nullptr;
+        size_ = 0;
+    }
+
+    void swap(btree_map& other) noexcept {
+        using std::swap;
+        swap(root_, other.root_);
+        swap(first_leaf_, other.first_leaf_);
+        swap(last_leaf_, other.last_leaf_);
+        swap(size_, other.size_);
+        swap(comp_, other.comp_);
+    }
+    friend void swap(btree_map& a, btree_map& b) noexcept { a.swap(b); }
+
+    iterator lower_bound(const Key& k) { return iterator(bound(k, false)); }
+    const_iterator lower_bound(const Key& k) const { return const_iterator(bound(k, false)); }
+    iterator upper_bound(const Key& k) { return iterator(bound(k, true)); }
+    const_iterator upper_bound(const Key& k) const { return const_iterator(bound(k, true)); }
+    std::pair<iterator, iterator> equal_range(const Key& k) { return {lower_bound(k), upper_bound(k)}; }
+    std::pair<const_iterator, const_iterator> equal_range(const Key& k) const { return {lower_bound(k), upper_bound(k)}; }
+
+    iterator find(const Key& k) {
+        auto it = lower_bound(k);
+        return (it != end() && !comp_(k, it->first)) ? it : end();
+    }
+    const_iterator find(const Key& k) const {
+        auto it = lower_bound(k);
+        return (it != end() && !comp_(k, it->first)) ? it : end();
+    }
+
+    bool contains(const Key& k) const { return find(k) != end(); }
+    size_type count(const Key& k) const { return contains(k) ? 1 : 0; }
+
+    friend bool operator==(const btree_map& a, const btree_map& b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const auto& x, const auto& y) {
+            return x.first == y.first && x.second == y.second;
+        });
+    }
+
+  private:
+    template<class, class, class> friend struct BtreeMapIterator;
+
+    // Node arrays have room for one more element than their nominal
+    // capacity, so that an insertion can always be performed in place
+    // first and the overfull node split afterward.
+    //
+    template<class U, std::size_t N>
+    struct uninitialized_array {
+        U *data() { return std::launder(reinterpret_cast<U*>(buf_)); }
+        const U *data() const { return std::launder(reinterpret_cast<const U*>(buf_)); }
+
+        template<class... Args>
+        void insert_at(unsigned count, unsigned pos, Args&&... args) {
+            U *p = data();
+            if (pos == count) {
+                ::new ((void*)(p + pos)) U(std::forward<Args>(args)...);
+            } else {
+                U tmp(std::forward<Args>(args)...);
+                ::new ((void*)(p + count)) U(std::move(p[count - 1]));
+                std::move_backward(p + pos, p + count - 1, p + count);
+                p[pos] = std::move(tmp);
+            }
+        }
+
+        void erase_at(unsigned count, unsigned pos) {
+            U *p = data();
+            std::move(p + pos + 1, p + count, p + pos);
+            std::destroy_at(p + count - 1);
+        }
+
+        // Moves elements [from, count) into the empty array `dst`.
+        void split_into(uninitialized_array& dst, unsigned count, unsigned from) {
+            U *p = data();
+            std::uninitialized_move(p + from, p + count, dst.data());
+            std::destroy(p + from, p + count);
+        }
+
+        void destroy(unsigned count) { std::destroy(data(), data() + count); }
+
+        alignas(U) unsigned char buf_[N * sizeof(U)];
+    };
+
+    struct node {
+        explicit node(bool leaf) : is_leaf(leaf) {}
+        bool is_leaf;
+        unsigned count = 0;
+    };
+
+    struct leaf_node : node {
+        leaf_node() : node(true) {}
+        ~leaf_node() {
+            keys.destroy(this->count);
+            values.destroy(this->count);
+        }
+
+        const Key& key(unsigned i) const { return keys.data()[i]; }
+
+        unsigned lower_bound(const Key& k, const Compare& comp) const {
+            return std::lower_bound(keys.data(), keys.data() + this->count, k, comp) - keys.data();
+        }
+
+        template<class K, class... Args>
+        void insert_at(unsigned pos, K&& k, Args&&... args) {
+            keys.insert_at(this->count, pos, std::forward<K>(k));
+            try {
+                values.insert_at(this->count, pos, std::forward<Args>(args)...);
+            } catch (...) {
+                keys.erase_at(this->count + 1, pos);
+                throw;
+            }
+            this->count += 1;
+        }
+
+        void erase_at(unsigned pos) {
+            keys.erase_at(this->count, pos);
+            values.erase_at(this->count, pos);
+            this->count -= 1;
+        }
+
+        leaf_node *prev = nullptr;
+        leaf_node *next = nullptr;
+        uninitialized_array<Key, leaf_capacity + 1> keys;
+        uninitialized_array<T, leaf_capacity + 1> values;
+    };
+
+    // An inner node with `count` keys has `count + 1` children. Every key
+    // in `children[i+1]` compares greater than or equal to `keys[i]`.
+    //
+    struct inner_node : node {
+        inner_node() : node(false) {}
+        ~inner_node() { keys.destroy(this->count); }
+
+        unsigned child_index(const Key& k, const Compare& comp) const {
+            const Key *p = keys.data();
+            return std::upper_bound(p, p + this->count, k, comp) - p;
+        }
+
+        uninitialized_array<Key, inner_capacity + 1> keys;
+        node *children[inner_capacity + 2];
+    };
+
+    // Splits only ever add one level at a time, and each split at least
+    // halves a node (or, on the append path, starts a new one), so 64
+    // levels are far more than any tree that fits in memory can reach.
+    //
+    struct path_entry {
+        inner_node *node;
+        unsigned child;
+    };
+    using path_type = path_entry[64];
+
+    leaf_node *descend(const Key& k, path_type& path, int& depth) const {
+        node *n = root_;
+        while (!n->is_leaf) {
+            auto *in = static_cast<inner_node*>(n);
+            unsigned i = in->child_index(k, comp_);
+            path[depth++] = {in, i};
+            n = in->children[i];
+        }
+        return static_cast<leaf_node*>(n);
+    }
+
+    leaf_node *split_leaf(leaf_node *leaf, unsigned split) {
+        leaf_node *right = new leaf_node;
+        leaf->keys.split_into(right->keys, leaf->count, split);
+        leaf->values.split_into(right->values, leaf->count, split);
+        right->count = leaf->count - split;
+        leaf->count = split;
+        right->prev = leaf;
+        right->next = leaf->next;
+        if (leaf->next != nullptr) {
+            leaf->next->prev = right;
+        } else {
+            last_leaf_ = right;
+        }
+        leaf->next = right;
+        return right;
+    }
+
+    // `right` has just been split off from the child at `path[depth-1]`;
+    // insert it (with separator `sep`) into that child's parent, splitting
+    // ancestors as needed.
+    //
+    void insert_into_parent(path_type& path, int depth, Key sep, node *right) {
+        while (depth != 0) {
+            auto [in, i] = path[--depth];
+            in->keys.insert_at(in->count, i, std::move(sep));
+            std::move_backward(in->children + i + 1, in->children + in->count + 1, in->children + in->count + 2);
+            in->children[i + 1] = right;
+            in->count += 1;
+            if (in->count <= inner_capacity) {
+                return;
+            }
+            unsigned mid = (i == inner_capacity) ? inner_capacity : (inner_capacity + 1) / 2;
+            auto *sibling = new inner_node;
+            in->keys.split_into(sibling->keys, in->count, mid + 1);
+            std::copy(in->children + mid + 1, in->children + in->count + 1, sibling->children);
+            sibling->count = in->count - mid - 1;
+            sep = std::move(in->keys.data()[mid]);
+            std::destroy_at(in->keys.data() + mid);
+            in->count = mid;
+            right = sibling;
+        }
+        auto *r = new inner_node;
+        r->keys.insert_at(0, 0, std::move(sep));
+        r->children[0] = root_;
+        r->children[1] = right;
+        r->count = 1;
+        root_ = r;
+    }
+
+    iterator erase_at(path_type& path, int depth, leaf_node *leaf, unsigned pos) {
+        leaf->erase_at(pos);
+        size_ -= 1;
+        if (size_ == 0) {
+            clear();
+            return end();
+        }
+        if (leaf->count != 0) {
+            return iterator(normalize(leaf, pos));
+        }
+        leaf_node *next = leaf->next;
+        (leaf->prev ? leaf->prev->next : first_leaf_) = leaf->next;
+        (leaf->next ? leaf->next->prev : last_leaf_) = leaf->prev;
+        delete leaf;
+        while (depth != 0) {
+            auto [in, i] = path[--depth];
+            if (in->count == 0) {
+                // `in` had no child but the one we just removed.
+                delete in;
+                continue;
+            }
+            unsigned k = (i != 0) ? i - 1 : 0;
+            in->keys.erase_at(in->count, k);
+            std::move(in->children + i + 1, in->children + in->count + 1, in->children + i);
+            in->count -= 1;
+            break;
+        }
+        while (!root_->is_leaf && root_->count == 0) {
+            auto *old = static_cast<inner_node*>(root_);
+            root_ = old->children[0];
+            delete old;
+        }
+        return next ? iterator(next, 0) : end();
+    }
+
+    struct position {
+        leaf_node *leaf;
+        unsigned idx;
+    };
+
+    // An iterator that points one past the last element of a leaf
+    // is valid only as `end()`; everywhere else it must be advanced to the
+    // first element of the next leaf.
+    //
+    position normalize(leaf_node *leaf, unsigned idx) const {
+        if (idx == leaf->count && leaf->next != nullptr) {
+            return {leaf->next, 0};
+        }
+        return {leaf, idx};
+    }
+
+    position bound(const Key& k, bool upper) const {
+        if (root_ == nullptr) {
+            return {nullptr, 0};
+        }
+        path_type path;
+        int depth = 0;
+        leaf_node *leaf = descend(k, path, depth);
+        const Key *p = leaf->keys.data();
+        unsigned idx = upper ? std::upper_bound(p, p + leaf->count, k, comp_) - p : leaf->lower_bound(k, comp_);
+        return normalize(leaf, idx);
+    }
+
+    static void destroy_subtree(node *n) {
+        if (n->is_leaf) {
+            delete static_cast<leaf_node*>(n);
+        } else {
+            auto *in = static_cast<inner_node*>(n);
+            for (unsigned i = 0; i <= in->count; ++i) {
+                destroy_subtree(in->children[i]);
+            }
+            delete in;
+        }
+    }
+
+    node *root_ = nullptr;
+    leaf_node *first_leaf_ = nullptr;
+    leaf_node *last_leaf_ = nullptr;
+    size_type size_ = 0;
+    [[no_unique_address]] Compare comp_;
+};
+
+// `BtreeMapIterator` is a (leaf, index) pair. Incrementing past the last
+// element of a leaf follows the leaf's `next` link, and decrementing past
+// the first follows its `prev` link; the inner nodes are never consulted.
+//
+// As with `flat_map`, there is no `std::pair<Key, T>` object in memory to
+// refer to, so `reference` is the proxy `pair_reference<const Key&, T&>`.
+//
+template<class QualifiedMap,
+         class UnqualifiedMap /* = std::remove_cv_t<QualifiedMap> */,
+         class Reference /* = pair_reference<const Key&, T&> */>
+struct BtreeMapIterator
+{
+    using iterator_concept = std::bidirectional_iterator_tag;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename UnqualifiedMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = arrow_proxy<Reference>;
+    using reference = Reference;
+
+    BtreeMapIterator() {}
+
+    friend UnqualifiedMap;
+    template<class, class, class> friend struct BtreeMapIterator;
+  private:
+    using leaf_node = typename UnqualifiedMap::leaf_node;
+    using position = typename UnqualifiedMap::position;
+
+    explicit BtreeMapIterator(leaf_node *leaf, unsigned idx) : leaf_(leaf), idx_(idx) {}
+    explicit BtreeMapIterator(position p) : leaf_(p.leaf), idx_(p.idx) {}
+  public:
+
+    BtreeMapIterator(BtreeMapIterator const&) = default;
+    BtreeMapIterator& operator=(BtreeMapIterator const&) = default;
+    BtreeMapIterator(BtreeMapIterator&&) noexcept = default;
+    BtreeMapIterator& operator=(BtreeMapIterator&&) = default;
+    ~BtreeMapIterator() = default;
+
+    BtreeMapIterator operator++(int) {
+        BtreeMapIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    BtreeMapIterator operator--(int) {
+        BtreeMapIterator tmp = *this;
+        --(*this);
+        return tmp;
+    }
+
+    // When we step onto a new leaf, start fetching the one after it,
+    // so that a long scan streams through memory.
+    //
+    BtreeMapIterator& operator++() {
+        idx_ += 1;
+        if (idx_ == leaf_->count && leaf_->next != nullptr) {
+            leaf_ = leaf_->next;
+            idx_ = 0;
+#if defined(__GNUC__)
+            __builtin_prefetch(leaf_->next);
+#endif
+        }
+        return *this;
+    }
+
+    BtreeMapIterator& operator--() {
+        if (idx_ == 0) {
+            leaf_ = leaf_->prev;
+            idx_ = leaf_->count;
+        }
+        idx_ -= 1;
+        return *this;
+    }
+
+    reference operator*() const { return reference(leaf_->keys.data()[idx_], leaf_->values.data()[idx_]); }
+
+    pointer operator->() const { return pointer{*(*this)}; }
+
+    // The `split_advance` customization point (see parallel.h): skip whole
+    // leaves at a time, reading only their counts.
+    //
+    friend void split_advance(BtreeMapIterator& it, difference_type n) {
+        while (n != 0 && n >= difference_type(it.leaf_->count - it.idx_) && it.leaf_->next != nullptr) {
+            n -= it.leaf_->count - it.idx_;
+            it.leaf_ = it.leaf_->next;
+            it.idx_ = 0;
+        }
+        it.idx_ += unsigned(n);
+    }
+
+    friend void swap(BtreeMapIterator& a, BtreeMapIterator& b) {
+        std::swap(a.leaf_, b.leaf_);
+        std::swap(a.idx_, b.idx_);
+    }
+
+    template<class QM>
+    bool operator==(BtreeMapIterator<QM> const& other) const { return leaf_ == other.leaf_ && idx_ == other.idx_; }
+
+    template<class QM>
+    bool operator!=(BtreeMapIterator<QM> const& other) const { return !(*this == other); }
+
+    operator BtreeMapIterator<const UnqualifiedMap>() const {
+        return BtreeMapIterator<const UnqualifiedMap>(leaf_, idx_);
+    }
+
+  private:
+    leaf_node *leaf_ = nullptr;
+    unsigned idx_ = 0;
+};
+
+static_assert(std::bidirectional_iterator<btree_map<int, int>::iterator>);
+static_assert(std::bidirectional_iterator<btree_map<int, int>::const_iterator>);
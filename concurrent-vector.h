@@ -0,0 +1,289 @@
+#pragma once
+
+#include <atomic>  // atomic, memory_order
+#include <bit>  // bit_width
+#include <cassert>  // assert
+#include <climits>  // CHAR_BIT
+#include <cstddef>  // ptrdiff_t, size_t
+#include <iterator>  // bidirectional_iterator, bidirectional_iterator_tag
+#include <memory>  // allocator, destroy_at
+#include <new>  // operator new
+#include <type_traits>  // remove_cv_t
+#include <utility>  // forward, move
+
+#include "reversible-container.h"
+
+template<
+    class QualifiedType,
+    class UnqualifiedType = std::remove_cv_t<QualifiedType>
+> struct ConcurrentVectorIterator;
+
+// `concurrent_vector<T>` is an append-only vector that any number of
+// threads may `push_back` into at once, while others read it, without a
+// mutex. Elements never move once constructed, so references and
+// iterators to them stay valid until the vector is destroyed.
+//
+// The elements live in segments whose sizes are successive powers of two,
+// 32, 64, 128, and so on, so that element `i` is found with one
+// `bit_width` and no search, and a vector of `n` elements has only about
+// `log2(n)` segments. A segment is allocated when the first element in it
+// is reserved; the threads that reserve later elements of the same segment
+// wait for it.
+//
+// `push_back` reserves an index with one `fetch_add`, constructs the
+// element in place, and then *publishes* it. Elements are published in
+// index order: `size()` is the length of the prefix in which every element
+// is fully constructed, and is all that readers (`operator[]`, `begin()`,
+// `end()`) ever see. A thread that finishes constructing its element before
+// the thread with the previous index does waits for that thread to publish,
+// so a thread descheduled in the middle of `push_back` briefly holds up the
+// others.
+//
+// Because publication can't be undone, `T`'s constructor must not throw:
+// `push_back` and `emplace_back` call `std::terminate` if it does (or if
+// allocating a segment fails).
+//
+// Destroying the vector is not thread-safe.
+//
+template<class T>
+class concurrent_vector : public reversible_container<concurrent_vector<T>> {
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = ConcurrentVectorIterator<T>;
+    using const_iterator = ConcurrentVectorIterator<const T>;
+    using reverse_iterator = reverse_iterator_t<iterator>;
+    using const_reverse_iterator = reverse_iterator_t<const_iterator>;
+
+    concurrent_vector() = default;
+    concurrent_vector(const concurrent_vector&) = delete;
+    concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+    ~concurrent_vector() {
+        size_type n = size_.load(std::memory_order_acquire);
+        for (size_type i = 0; i < n; ++i) {
+            std::destroy_at(slot(i));
+        }
+        for (unsigned k = 0; k < segment_count; ++k) {
+            if (T *seg = segments_[k].load(std::memory_order_relaxed)) {
+                std::allocator<T>().deallocate(seg, segment_size(k));
+            }
+        }
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(this, 0); }
+    iterator end() { return iterator(this, size()); }
+    const_iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(this, size()); }
+
+    // The number of published elements. It only grows.
+    //
+    size_type size() const noexcept { return size_.load(std::memory_order_acquire); }
+    bool empty() const noexcept { return size() == 0; }
+
+    // `i` must be less than a value previously returned by `size()`.
+    //
+    reference operator[](size_type i) { assert(i < size()); return *slot(i); }
+    const_reference operator[](size_type i) const { assert(i < size()); return *slot(i); }
+
+    // Thread-safe. Returns an iterator to the new element, which has been
+    // published by the time this returns.
+    //
+    template<class... Args>
+    iterator emplace_back(Args&&... args) {
+        size_type i = reserved_.fetch_add(1, std::memory_order_relaxed);
+        construct_and_publish(i, std::forward<Args>(args)...);
+        return iterator(this, i);
+    }
+
+    iterator push_back(const T& value) { return emplace_back(value); }
+    iterator push_back(T&& value) { return emplace_back(std::move(value)); }
+
+    // Thread-safe. Allocates the segments for the first `n` elements now,
+    // so that `push_back` won't have to.
+    //
+    void reserve(size_type n) {
+        for (unsigned k = 0; k < segment_count && segment_base(k) < n; ++k) {
+            if (segments_[k].load(std::memory_order_acquire) == nullptr) {
+                allocate_segment(k);
+            }
+        }
+    }
+
+  private:
+    template<class, class> friend struct ConcurrentVectorIterator;
+
+    static constexpr unsigned first_segment_bits = 5;
+    static constexpr size_type first_segment_size = size_type(1) << first_segment_bits;
+    static constexpr unsigned segment_count = sizeof(size_type) * CHAR_BIT - first_segment_bits;
+    static constexpr size_type cache_line = 64;
+
+    // How many times a thread polls before going to sleep while waiting for
+    // a segment to be allocated or for its predecessor to publish.
+    static constexpr int spin_limit = 64;
+
+    // Segment `k` holds elements [segment_base(k), segment_base(k+1)).
+    //
+    static unsigned segment_of(size_type i) noexcept {
+        return unsigned(std::bit_width(i + first_segment_size)) - 1 - first_segment_bits;
+    }
+    static size_type segment_base(unsigned k) noexcept { return (first_segment_size << k) - first_segment_size; }
+    static size_type segment_size(unsigned k) noexcept { return first_segment_size << k; }
+
+    static void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    // The segment of a published element was allocated before the element
+    // was published, so a relaxed load suffices here.
+    //
+    T *slot(size_type i) const noexcept {
+        unsigned k = segment_of(i);
+        return segments_[k].load(std::memory_order_relaxed) + (i - segment_base(k));
+    }
+
+    T *allocate_segment(unsigned k) {
+        T *seg = std::allocator<T>().allocate(segment_size(k));
+        T *expected = nullptr;
+        if (!segments_[k].compare_exchange_strong(expected, seg, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            std::allocator<T>().deallocate(seg, segment_size(k));
+            return expected;
+        }
+        segments_[k].notify_all();
+        return seg;
+    }
+
+    T *wait_for_segment(unsigned k) const noexcept {
+        for (int spins = 0; ; ++spins) {
+            if (T *seg = segments_[k].load(std::memory_order_acquire)) {
+                return seg;
+            }
+            if (spins < spin_limit) {
+                cpu_relax();
+            } else {
+                segments_[k].wait(nullptr, std::memory_order_acquire);
+            }
+        }
+    }
+
+    // Index `i` has been reserved by this thread. Whichever thread reserved
+    // the first index of a segment allocates it. Everything from here on
+    // must happen exactly once, so it's `noexcept`.
+    //
+    template<class... Args>
+    void construct_and_publish(size_type i, Args&&... args) noexcept {
+        unsigned k = segment_of(i);
+        T *seg = segments_[k].load(std::memory_order_acquire);
+        if (seg == nullptr) {
+            seg = (i == segment_base(k)) ? allocate_segment(k) : wait_for_segment(k);
+        }
+        ::new (static_cast<void*>(seg + (i - segment_base(k)))) T(std::forward<Args>(args)...);
+
+        // Every thread acquires its predecessor's release of `size_` before
+        // releasing its own, so a reader that acquires `size_ == n` sees all
+        // `n` elements constructed.
+        int spins = 0;
+        for (size_type s; (s = size_.load(std::memory_order_acquire)) != i; ) {
+            if (++spins < spin_limit) {
+                cpu_relax();
+            } else {
+                size_.wait(s, std::memory_order_acquire);
+            }
+        }
+        size_.store(i + 1, std::memory_order_release);
+        size_.notify_all();
+    }
+
+    // The index counter that writers contend on, the published size that
+    // readers poll, and the segment table each have their own cache line.
+    alignas(cache_line) std::atomic<size_type> reserved_ = 0;
+    alignas(cache_line) std::atomic<size_type> size_ = 0;
+    alignas(cache_line) std::atomic<T*> segments_[segment_count] = {};
+};
+
+// A `ConcurrentVectorIterator` is an index into its vector. Moving it never
+// reads the vector, so it remains valid however many elements are appended
+// meanwhile; but an iterator obtained from `end()` stays where it was, at
+// the size at the time of the call.
+//
+template<class QualifiedType,
+         class UnqualifiedType /* = std::remove_cv_t<QualifiedType> */>
+struct ConcurrentVectorIterator
+{
+    using iterator_concept = std::bidirectional_iterator_tag;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = UnqualifiedType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = QualifiedType*;
+    using reference = QualifiedType&;
+
+    ConcurrentVectorIterator() {}
+
+    friend class concurrent_vector<UnqualifiedType>;
+    template<class, class> friend struct ConcurrentVectorIterator;
+  private:
+    explicit ConcurrentVectorIterator(const concurrent_vector<UnqualifiedType> *vec, std::size_t index) :
+        vec_(vec), index_(index) {}
+  public:
+
+    ConcurrentVectorIterator(ConcurrentVectorIterator const&) = default;
+    ConcurrentVectorIterator& operator=(ConcurrentVectorIterator const&) = default;
+    ConcurrentVectorIterator(ConcurrentVectorIterator&&) noexcept = default;
+    ConcurrentVectorIterator& operator=(ConcurrentVectorIterator&&) = default;
+    ~ConcurrentVectorIterator() = default;
+
+    ConcurrentVectorIterator operator++(int) {
+        ConcurrentVectorIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    ConcurrentVectorIterator operator--(int) {
+        ConcurrentVectorIterator tmp = *this;
+        --(*this);
+        return tmp;
+    }
+
+    ConcurrentVectorIterator& operator++() { ++index_; return *this; }
+    ConcurrentVectorIterator& operator--() { --index_; return *this; }
+
+    reference operator*() const { return *vec_->slot(index_); }
+    pointer operator->() const { return vec_->slot(index_); }
+
+    // The `split_advance` customization point (see parallel.h): finding an
+    // element by its index is O(1).
+    //
+    friend void split_advance(ConcurrentVectorIterator& it, difference_type n) { it.index_ += n; }
+
+    friend void swap(ConcurrentVectorIterator& a, ConcurrentVectorIterator& b) {
+        ConcurrentVectorIterator tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    template<class QT>
+    bool operator==(ConcurrentVectorIterator<QT> const& other) const {
+        return vec_ == other.vec_ && index_ == other.index_;
+    }
+
+    template<class QT>
+    bool operator!=(ConcurrentVectorIterator<QT> const& other) const { return !(*this == other); }
+
+    operator ConcurrentVectorIterator<const UnqualifiedType>() const {
+        return ConcurrentVectorIterator<const UnqualifiedType>(vec_, index_);
+    }
+
+  private:
+    const concurrent_vector<UnqualifiedType> *vec_ = nullptr;
+    std::size_t index_ = 0;
+};
+
+static_assert(std::bidirectional_iterator<concurrent_vector<int>::iterator>);
+static_assert(std::bidirectional_iterator<concurrent_vector<int>::const_iterator>);
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <algorithm>  // copy, fill_n, lower_bound
+#include <array>  // array
+#include <bit>  // bit_width
+#include <cassert>  // assert
+#include <climits>  // CHAR_BIT
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint8_t, uint32_t
+#include <initializer_list>  // initializer_list
+#include <iterator>  // forward_iterator, forward_iterator_tag, input_iterator_tag
+#include <type_traits>  // is_unsigned_v
+#include <vector>  // vector
+
+template<class T = std::uint32_t> struct DeltaSequenceIterator;
+
+// `delta_sequence` is an append-only, compressed sequence of non-decreasing
+// unsigned integers, such as a posting list or a series of timestamps.
+//
+// Values are stored as the differences between consecutive elements, in
+// blocks of 128. Each block is bit-packed at the smallest width that fits its
+// largest difference, in the lane-interleaved layout of Lemire and Boytsov,
+// "Decoding billions of integers per second through vectorization" (2015):
+// a block is `lanes` interleaved streams, so that unpacking it is a loop of
+// identical shifts and masks across the lanes, which the compiler vectorizes.
+// A block of width `b` occupies exactly `16 * b` bytes.
+//
+// Each block also has a small header holding its last value, which doubles
+// as a skip pointer: `DeltaSequenceIterator::skip_to` binary-searches the
+// headers and decodes only the block it lands in.
+//
+// The last `size() % 128` values are kept uncompressed until their block
+// fills up.
+//
+template<class T = std::uint32_t>
+class delta_sequence {
+    static_assert(std::is_unsigned_v<T>);
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = DeltaSequenceIterator<T>;
+    using const_iterator = DeltaSequenceIterator<T>;
+
+    static constexpr size_type block_size = 128;
+    static constexpr size_type lanes = block_size / (sizeof(T) * CHAR_BIT);
+
+    delta_sequence() = default;
+
+    template<class InputIt>
+    delta_sequence(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    delta_sequence(std::initializer_list<T> il) : delta_sequence(il.begin(), il.end()) {}
+
+    iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(this); }
+    iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(); }
+
+    size_type size() const noexcept { return blocks_.size() * block_size + tail_.size(); }
+    bool empty() const noexcept { return size() == 0; }
+
+    T back() const {
+        assert(!empty());
+        return tail_.empty() ? blocks_.back().last : tail_.back();
+    }
+
+    // The values must be pushed in non-decreasing order.
+    //
+    void push_back(T value) {
+        assert(empty() || back() <= value);
+        tail_.push_back(value);
+        if (tail_.size() == block_size) {
+            flush_tail();
+        }
+    }
+
+    void clear() noexcept {
+        blocks_.clear();
+        data_.clear();
+        tail_.clear();
+    }
+
+    void shrink_to_fit() {
+        blocks_.shrink_to_fit();
+        data_.shrink_to_fit();
+    }
+
+    // The number of bytes used to hold the elements, not counting
+    // unused capacity or `sizeof(*this)`.
+    //
+    size_type memory_bytes() const noexcept {
+        return blocks_.size() * sizeof(block_header) + (data_.size() + tail_.size()) * sizeof(T);
+    }
+
+    bool contains(T value) const {
+        const_iterator it = begin();
+        it.skip_to(value);
+        return it != end() && *it == value;
+    }
+
+  private:
+    template<class> friend struct DeltaSequenceIterator;
+
+    static constexpr unsigned bits = sizeof(T) * CHAR_BIT;
+
+    struct block_header {
+        T last;
+        std::size_t offset;
+        std::uint8_t width;
+    };
+
+    void flush_tail() {
+        T deltas[block_size];
+        T prev = blocks_.empty() ? T(0) : blocks_.back().last;
+        T all = 0;
+        for (size_type i = 0; i < block_size; ++i) {
+            deltas[i] = tail_[i] - prev;
+            prev = tail_[i];
+            all |= deltas[i];
+        }
+        unsigned width = std::bit_width(all);
+        size_type offset = data_.size();
+        data_.resize(offset + lanes * width);
+        pack(deltas, data_.data() + offset, width);
+        blocks_.push_back({tail_.back(), offset, std::uint8_t(width)});
+        tail_.clear();
+    }
+
+    // Value `i` of a block belongs to lane `i % lanes`, and is the
+    // `(i / lanes)`th value of that lane. Word `k` of each lane's bit stream
+    // is stored at `out[k * lanes + lane]`.
+    //
+    static void pack(const T *in, T *out, unsigned width) {
+        for (size_type j = 0; width != 0 && j < block_size / lanes; ++j) {
+            size_type bit = j * width;
+            unsigned shift = bit % bits;
+            T *lo = out + (bit / bits) * lanes;
+            const T *src = in + j * lanes;
+            for (size_type l = 0; l < lanes; ++l) {
+                lo[l] |= T(src[l] << shift);
+            }
+            if (shift + width > bits) {
+                T *hi = lo + lanes;
+                for (size_type l = 0; l < lanes; ++l) {
+                    hi[l] |= T(src[l] >> (bits - shift));
+                }
+            }
+        }
+    }
+
+    static void unpack(const T *in, T *out, unsigned width) {
+        if (width == 0) {
+            std::fill_n(out, block_size, T(0));
+            return;
+        }
+        T mask = (width == bits) ? T(~T(0)) : T((T(1) << width) - 1);
+        for (size_type j = 0; j < block_size / lanes; ++j) {
+            size_type bit = j * width;
+            unsigned shift = bit % bits;
+            const T *lo = in + (bit / bits) * lanes;
+            T *dst = out + j * lanes;
+            if (shift + width <= bits) {
+                for (size_type l = 0; l < lanes; ++l) {
+                    dst[l] = T(lo[l] >> shift) & mask;
+                }
+            } else {
+                const T *hi = lo + lanes;
+                for (size_type l = 0; l < lanes; ++l) {
+                    dst[l] = T(T(lo[l] >> shift) | T(hi[l] << (bits - shift))) & mask;
+                }
+            }
+        }
+    }
+
+    void decode_block(size_type b, T *out) const {
+        unpack(data_.data() + blocks_[b].offset, out, blocks_[b].width);
+        T value = (b == 0) ? T(0) : blocks_[b - 1].last;
+        for (size_type i = 0; i < block_size; ++i) {
+            value += out[i];
+            out[i] = value;
+        }
+    }
+
+    std::vector<block_header> blocks_;
+    std::vector<T> data_;
+    std::vector<T> tail_;
+};
+
+// `DeltaSequenceIterator` decodes a `delta_sequence` one block at a time
+// into a buffer of 128 values, so that incrementing and dereferencing are
+// as cheap as for a plain array, and the cost of unpacking is paid once
+// per block. This makes the iterator itself about half a kilobyte; pass
+// it by reference where that matters.
+//
+// Since the values it produces live in the iterator's own buffer, its
+// `reference` type is `T` (a prvalue) and it has no `operator->`. That
+// makes it only an input iterator by the C++17 requirements, which is what
+// its `iterator_category` says; its `iterator_concept` says that it's a
+// C++20 forward iterator.
+//
+// A default-constructed `DeltaSequenceIterator` is the end iterator of
+// every range.
+//
+template<class T>
+struct DeltaSequenceIterator
+{
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = T;
+
+    DeltaSequenceIterator() {}
+
+    template<class> friend class delta_sequence;
+  private:
+    explicit DeltaSequenceIterator(const delta_sequence<T> *seq) : seq_(seq) { load(0); }
+  public:
+
+    DeltaSequenceIterator(DeltaSequenceIterator const&) = default;
+    DeltaSequenceIterator& operator=(DeltaSequenceIterator const&) = default;
+    DeltaSequenceIterator(DeltaSequenceIterator&&) noexcept = default;
+    DeltaSequenceIterator& operator=(DeltaSequenceIterator&&) = default;
+    ~DeltaSequenceIterator() = default;
+
+    DeltaSequenceIterator operator++(int) {
+        DeltaSequenceIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    DeltaSequenceIterator& operator++() {
+        if (++pos_ == count_) {
+            load(block_ + 1);
+        }
+        return *this;
+    }
+
+    reference operator*() const { return buf_[pos_]; }
+
+    // Advances to the first element not less than `value`, or to the end.
+    // Blocks that lie entirely below `value` are skipped without being
+    // decoded, which makes this suitable for galloping intersection of
+    // posting lists. It never moves backward.
+    //
+    void skip_to(T value) {
+        if (seq_ == nullptr || buf_[pos_] >= value) {
+            return;
+        }
+        if (buf_[count_ - 1] < value) {
+            const auto& blocks = seq_->blocks_;
+            if (block_ >= blocks.size()) {
+                *this = DeltaSequenceIterator();
+                return;
+            }
+            auto it = std::lower_bound(blocks.begin() + block_ + 1, blocks.end(), value,
+                [](const auto& h, T v) { return h.last < v; });
+            load(it - blocks.begin());
+            if (seq_ == nullptr) {
+                return;
+            }
+        }
+        pos_ = std::lower_bound(buf_.begin() + pos_, buf_.begin() + count_, value) - buf_.begin();
+        if (pos_ == count_) {
+            load(block_ + 1);
+        }
+    }
+
+    // The `split_advance` customization point (see parallel.h): every block
+    // but the tail holds exactly `block_size` values, so the target block is
+    // known without decoding any of the blocks in between.
+    //
+    friend void split_advance(DeltaSequenceIterator& it, difference_type n) {
+        if (n == 0) {
+            return;
+        }
+        std::size_t target = it.block_ * delta_sequence<T>::block_size + it.pos_ + std::size_t(n);
+        std::size_t b = target / delta_sequence<T>::block_size;
+        if (b != it.block_) {
+            it.load(b);
+            if (it.seq_ == nullptr) {
+                return;
+            }
+        }
+        it.pos_ = target % delta_sequence<T>::block_size;
+        if (it.pos_ == it.count_) {
+            it.load(it.block_ + 1);
+        }
+    }
+
+    friend void swap(DeltaSequenceIterator& a, DeltaSequenceIterator& b) {
+        DeltaSequenceIterator tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    bool operator==(DeltaSequenceIterator const& other) const {
+        return seq_ == other.seq_ && block_ == other.block_ && pos_ == other.pos_;
+    }
+
+    bool operator!=(DeltaSequenceIterator const& other) const { return !(*this == other); }
+
+  private:
+    // Block `blocks_.size()` is the uncompressed tail.
+    void load(std::size_t b) {
+        std::size_t nblocks = seq_->blocks_.size();
+        if (b < nblocks) {
+            seq_->decode_block(b, buf_.data());
+            count_ = delta_sequence<T>::block_size;
+        } else if (b == nblocks && !seq_->tail_.empty()) {
+            std::copy(seq_->tail_.begin(), seq_->tail_.end(), buf_.begin());
+            count_ = seq_->tail_.size();
+        } else {
+            *this = DeltaSequenceIterator();
+            return;
+        }
+        block_ = b;
+        pos_ = 0;
+    }
+
+    const delta_sequence<T> *seq_ = nullptr;
+    std::size_t block_ = 0;
+    std::size_t pos_ = 0;
+    std::size_t count_ = 0;
+    std::array<T, delta_sequence<T>::block_size> buf_{};
+};
+
+static_assert(std::forward_iterator<delta_sequence<>::iterator>);
+static_assert(std::forward_iterator<delta_sequence<>::const_iterator>);
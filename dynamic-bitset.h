@@ -0,0 +1,322 @@
+#pragma once
+
+#include <bit>  // countr_zero, popcount
+#include <cassert>  // assert
+#include <climits>  // CHAR_BIT
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint64_t
+#include <iterator>  // forward_iterator, forward_iterator_tag, input_iterator_tag
+#include <ranges>  // disable_sized_range
+#include <type_traits>  // is_unsigned_v
+#include <vector>  // vector
+
+template<class Word = std::uint64_t> struct SetBitIterator;
+
+// `dynamic_bitset` is a runtime-sized sequence of bits, packed into an
+// array of `Word`s. Viewed as a container, it is the *set of the positions
+// of its 1 bits*: `begin()` and `end()` iterate over those positions in
+// ascending order, and `size()` is the number of bits, not the number of
+// set bits (which is `count()`).
+//
+// Every bulk operation (`count`, `find_first`, `find_next`, and the
+// bitwise operators) works a whole word at a time, in simple loops over
+// the word arrays that the compiler can auto-vectorize.
+//
+// Invariant: the bits of the last word beyond `size()` are always zero,
+// so that whole-word operations never need to mask them off.
+//
+template<class Word = std::uint64_t>
+class dynamic_bitset {
+    static_assert(std::is_unsigned_v<Word>);
+
+  public:
+    using word_type = Word;
+    using size_type = std::size_t;
+    using value_type = std::size_t;
+    using iterator = SetBitIterator<Word>;
+    using const_iterator = SetBitIterator<Word>;
+
+    static constexpr size_type bits_per_word = sizeof(Word) * CHAR_BIT;
+    static constexpr size_type npos = size_type(-1);
+
+    dynamic_bitset() = default;
+    explicit dynamic_bitset(size_type nbits, bool value = false)
+        : words_(words_for(nbits), value ? ~Word(0) : Word(0)), nbits_(nbits)
+    {
+        clear_tail();
+    }
+
+    iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(words_.data(), words_.size()); }
+    iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(); }
+
+    size_type size() const noexcept { return nbits_; }
+    bool empty() const noexcept { return nbits_ == 0; }
+
+    void resize(size_type nbits, bool value = false) {
+        size_type old = nbits_;
+        words_.resize(words_for(nbits), value ? ~Word(0) : Word(0));
+        nbits_ = nbits;
+        if (value && old < nbits && old % bits_per_word != 0) {
+            words_[old / bits_per_word] |= ~Word(0) << (old % bits_per_word);
+        }
+        clear_tail();
+    }
+
+    bool test(size_type i) const { return (words_[i / bits_per_word] >> (i % bits_per_word)) & 1; }
+    bool operator[](size_type i) const { return test(i); }
+
+    dynamic_bitset& set(size_type i) { words_[i / bits_per_word] |= bit(i); return *this; }
+    dynamic_bitset& reset(size_type i) { words_[i / bits_per_word] &= ~bit(i); return *this; }
+    dynamic_bitset& flip(size_type i) { words_[i / bits_per_word] ^= bit(i); return *this; }
+    dynamic_bitset& set(size_type i, bool value) { return value ? set(i) : reset(i); }
+
+    dynamic_bitset& set() {
+        for (Word& w : words_) {
+            w = ~Word(0);
+        }
+        clear_tail();
+        return *this;
+    }
+
+    dynamic_bitset& reset() {
+        for (Word& w : words_) {
+            w = 0;
+        }
+        return *this;
+    }
+
+    dynamic_bitset& flip() {
+        for (Word& w : words_) {
+            w = ~w;
+        }
+        clear_tail();
+        return *this;
+    }
+
+    size_type count() const noexcept {
+        size_type n = 0;
+        for (Word w : words_) {
+            n += std::popcount(w);
+        }
+        return n;
+    }
+
+    bool any() const noexcept {
+        Word acc = 0;
+        for (Word w : words_) {
+            acc |= w;
+        }
+        return acc != 0;
+    }
+    bool none() const noexcept { return !any(); }
+    bool all() const noexcept { return count() == nbits_; }
+
+    // Returns the position of the lowest set bit, or `npos` if none is set.
+    //
+    size_type find_first() const noexcept { return scan_from(0, words_.empty() ? 0 : words_[0]); }
+
+    // Returns the position of the lowest set bit after `pos`,
+    // or `npos` if there is none.
+    //
+    size_type find_next(size_type pos) const noexcept {
+        size_type i = pos + 1;
+        if (i >= nbits_) {
+            return npos;
+        }
+        size_type w = i / bits_per_word;
+        return scan_from(w, words_[w] & (~Word(0) << (i % bits_per_word)));
+    }
+
+    // The binary operators require both operands to have the same `size()`.
+    //
+    dynamic_bitset& operator&=(const dynamic_bitset& rhs) { return apply(rhs, [](Word a, Word b) { return a & b; }); }
+    dynamic_bitset& operator|=(const dynamic_bitset& rhs) { return apply(rhs, [](Word a, Word b) { return a | b; }); }
+    dynamic_bitset& operator^=(const dynamic_bitset& rhs) { return apply(rhs, [](Word a, Word b) { return a ^ b; }); }
+    dynamic_bitset& operator-=(const dynamic_bitset& rhs) { return apply(rhs, [](Word a, Word b) { return a & ~b; }); }
+
+    friend dynamic_bitset operator&(dynamic_bitset a, const dynamic_bitset& b) { return a &= b; }
+    friend dynamic_bitset operator|(dynamic_bitset a, const dynamic_bitset& b) { return a |= b; }
+    friend dynamic_bitset operator^(dynamic_bitset a, const dynamic_bitset& b) { return a ^= b; }
+    friend dynamic_bitset operator-(dynamic_bitset a, const dynamic_bitset& b) { return a -= b; }
+    dynamic_bitset operator~() const { return dynamic_bitset(*this).flip(); }
+
+    // Equivalent to `(a & b).count()`, without materializing `a & b`.
+    //
+    friend size_type intersection_count(const dynamic_bitset& a, const dynamic_bitset& b) {
+        assert(a.nbits_ == b.nbits_);
+        const Word *pa = a.words_.data();
+        const Word *pb = b.words_.data();
+        size_type n = 0;
+        for (size_type i = 0, e = a.words_.size(); i < e; ++i) {
+            n += std::popcount(Word(pa[i] & pb[i]));
+        }
+        return n;
+    }
+
+    friend bool operator==(const dynamic_bitset& a, const dynamic_bitset& b) {
+        return a.nbits_ == b.nbits_ && a.words_ == b.words_;
+    }
+
+    const Word *data() const noexcept { return words_.data(); }
+    size_type num_words() const noexcept { return words_.size(); }
+
+  private:
+    static size_type words_for(size_type nbits) { return (nbits + bits_per_word - 1) / bits_per_word; }
+    static Word bit(size_type i) { return Word(1) << (i % bits_per_word); }
+
+    void clear_tail() {
+        if (nbits_ % bits_per_word != 0) {
+            words_.back() &= ~(~Word(0) << (nbits_ % bits_per_word));
+        }
+    }
+
+    size_type scan_from(size_type w, Word word) const noexcept {
+        size_type n = words_.size();
+        while (word == 0) {
+            if (++w >= n) {
+                return npos;
+            }
+            word = words_[w];
+        }
+        return w * bits_per_word + std::countr_zero(word);
+    }
+
+    // An element-wise loop over two word arrays. (They are either disjoint
+    // or, as in `a &= a`, identical, so this is correct either way.)
+    // At -O3, GCC and Clang vectorize it behind a runtime overlap check.
+    //
+    template<class Op>
+    dynamic_bitset& apply(const dynamic_bitset& rhs, Op op) {
+        assert(nbits_ == rhs.nbits_);
+        Word *pa = words_.data();
+        const Word *pb = rhs.words_.data();
+        for (size_type i = 0, e = words_.size(); i < e; ++i) {
+            pa[i] = op(pa[i], pb[i]);
+        }
+        return *this;
+    }
+
+    std::vector<Word> words_;
+    size_type nbits_ = 0;
+};
+
+// `SetBitIterator` visits the set bits of a word array in ascending order.
+// It holds a copy of the current word with the already-visited bits cleared:
+// dereferencing is a `countr_zero` on that copy, and incrementing clears its
+// lowest set bit (`w &= w - 1`), moving on to the next nonzero word when it
+// runs out. The cost is proportional to the number of set bits plus the
+// number of words, not the number of bits.
+//
+// Since the positions it produces aren't stored anywhere, its `reference`
+// type is `std::size_t` (a prvalue) and it has no `operator->`. That makes
+// it only an input iterator by the C++17 requirements, which is what its
+// `iterator_category` says; its `iterator_concept` says that it's a C++20
+// forward iterator.
+//
+// A default-constructed `SetBitIterator` is the end iterator of every range.
+//
+template<class Word>
+struct SetBitIterator
+{
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::size_t;
+
+    SetBitIterator() {}
+
+    template<class> friend class dynamic_bitset;
+  private:
+    // With no words, this stays the end iterator, even if `words` isn't null
+    // (as after `resize(0)`).
+    //
+    explicit SetBitIterator(const Word *words, std::size_t nwords) {
+        if (nwords != 0) {
+            words_ = words;
+            nwords_ = nwords;
+            cur_ = words_[0];
+            skip_empty_words();
+        }
+    }
+  public:
+
+    SetBitIterator(SetBitIterator const&) = default;
+    SetBitIterator& operator=(SetBitIterator const&) = default;
+    SetBitIterator(SetBitIterator&&) noexcept = default;
+    SetBitIterator& operator=(SetBitIterator&&) = default;
+    ~SetBitIterator() = default;
+
+    SetBitIterator operator++(int) {
+        SetBitIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    SetBitIterator& operator++() {
+        cur_ &= cur_ - 1;
+        skip_empty_words();
+        return *this;
+    }
+
+    reference operator*() const {
+        return idx_ * (sizeof(Word) * CHAR_BIT) + std::countr_zero(cur_);
+    }
+
+    // The `split_advance` customization point (see parallel.h): skip whole
+    // words at a time, counting their set bits with `popcount`.
+    //
+    friend void split_advance(SetBitIterator& it, difference_type n) {
+        while (n != 0 && n >= std::popcount(it.cur_)) {
+            n -= std::popcount(it.cur_);
+            it.cur_ = 0;
+            it.skip_empty_words();
+        }
+        for (; n != 0; --n) {
+            it.cur_ &= it.cur_ - 1;
+        }
+    }
+
+    friend void swap(SetBitIterator& a, SetBitIterator& b) {
+        SetBitIterator tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    // Once exhausted, every iterator resets itself to the default-constructed
+    // state, which is how it comes to compare equal to `end()`.
+    //
+    bool operator==(SetBitIterator const& other) const {
+        return words_ == other.words_ && idx_ == other.idx_ && cur_ == other.cur_;
+    }
+
+    bool operator!=(SetBitIterator const& other) const { return !(*this == other); }
+
+  private:
+    void skip_empty_words() {
+        while (cur_ == 0) {
+            if (++idx_ >= nwords_) {
+                *this = SetBitIterator();
+                return;
+            }
+            cur_ = words_[idx_];
+        }
+    }
+
+    const Word *words_ = nullptr;
+    std::size_t nwords_ = 0;
+    std::size_t idx_ = 0;
+    Word cur_ = 0;
+};
+
+// [range.prim.size]: Since `size()` doesn't count the elements of the range,
+// tell `std::ranges::size` not to use it.
+//
+template<class Word>
+inline constexpr bool std::ranges::disable_sized_range<dynamic_bitset<Word>> = true;
+
+static_assert(std::forward_iterator<dynamic_bitset<>::iterator>);
+static_assert(std::forward_iterator<dynamic_bitset<>::const_iterator>);
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>  // min, sort
+#include <bit>  // bit_floor, bit_width, countr_one
+#include <cstddef>  // ptrdiff_t, size_t
+#include <functional>  // less
+#include <initializer_list>  // initializer_list
+#include <iterator>  // forward_iterator, forward_iterator_tag
+#include <memory>  // addressof
+#include <type_traits>  // remove_cv_t
+#include <utility>  // move
+#include <vector>  // vector
+
+template<
+    class QualifiedType,
+    class UnqualifiedType = std::remove_cv_t<QualifiedType>
+> struct EytzingerIterator;
+
+// `eytzinger_array` stores a sorted sequence in breadth-first ("Eytzinger")
+// order: element 1 is the root of an implicit binary search tree, and the
+// children of element k are elements 2k and 2k+1. (Element 0 is unused.)
+//
+// The top levels of the tree are packed together at the front of the array,
+// so they stay hot in cache across many lookups; and the descendants of k
+// that are four levels down, 16k through 16k+15, are contiguous. That lets
+// `lower_bound` prefetch the cache line it will need four iterations from now,
+// hiding most of the memory latency that dominates an ordinary binary search
+// over a large array.
+//
+// The contents are immutable once constructed: this is a container for
+// static lookup tables.
+//
+template<class T, class Compare = std::less<T>>
+class eytzinger_array {
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = const T&;
+    using const_reference = const T&;
+    using iterator = EytzingerIterator<const T>;
+    using const_iterator = EytzingerIterator<const T>;
+
+    eytzinger_array() = default;
+
+    // Takes a sequence in any order, sorts it, and lays it out.
+    //
+    explicit eytzinger_array(std::vector<T> elements, const Compare& comp = Compare())
+        : comp_(comp)
+    {
+        std::sort(elements.begin(), elements.end(), comp_);
+        layout(std::move(elements));
+    }
+
+    template<class InputIt>
+    eytzinger_array(InputIt first, InputIt last, const Compare& comp = Compare())
+        : eytzinger_array(std::vector<T>(first, last), comp) {}
+
+    eytzinger_array(std::initializer_list<T> il, const Compare& comp = Compare())
+        : eytzinger_array(std::vector<T>(il), comp) {}
+
+    // Iteration visits the elements in sorted order, by walking the
+    // implicit tree in-order. That's much slower than a linear scan of
+    // the underlying array, so if you don't care about the order,
+    // use `layout_data()` instead.
+    //
+    iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(tree_.data(), n_ ? std::bit_floor(n_) : 0, n_); }
+    iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(tree_.data(), 0, n_); }
+
+    bool empty() const noexcept { return n_ == 0; }
+    size_type size() const noexcept { return n_; }
+
+    // Returns a pointer to the `size()` elements in Eytzinger order.
+    //
+    const T* layout_data() const noexcept { return tree_.data() + 1; }
+
+    const_iterator lower_bound(const T& x) const {
+        return const_iterator(tree_.data(), descend([&](const T& elt) { return comp_(elt, x); }), n_);
+    }
+
+    const_iterator upper_bound(const T& x) const {
+        return const_iterator(tree_.data(), descend([&](const T& elt) { return !comp_(x, elt); }), n_);
+    }
+
+    const_iterator find(const T& x) const {
+        auto it = lower_bound(x);
+        return (it != end() && !comp_(x, *it)) ? it : end();
+    }
+
+    bool contains(const T& x) const { return find(x) != end(); }
+
+  private:
+    // Each iteration of the loop below moves one level down the tree:
+    // to the right child if `go_right(tree_[k])`, otherwise to the left.
+    // The comparison result feeds straight into the index arithmetic, so
+    // there is no branch to mispredict.
+    //
+    // When we fall off the bottom of the tree, the bits of `k` below the
+    // leading 1 record the path we took: a 1 for each right turn. The answer
+    // is the last node at which we turned left, which we recover by
+    // stripping the trailing right turns plus that final left turn.
+    // If we never turned left, `k` becomes 0, which is `end()`.
+    //
+    template<class GoRight>
+    size_type descend(GoRight go_right) const {
+        const T* t = tree_.data();
+        size_type k = 1;
+        while (k <= n_) {
+#if defined(__GNUC__)
+            __builtin_prefetch(t + std::min(k * prefetch_stride, n_));
+#endif
+            k = 2 * k + go_right(t[k]);
+        }
+        return k >> (std::countr_one(k) + 1);
+    }
+
+    // Fills `tree_[k]` for every k in the subtree rooted at `k`, consuming
+    // `sorted[i]` in order. The recursion depth is log2(n).
+    //
+    void fill(std::vector<T>& sorted, size_type& i, size_type k) {
+        if (k <= n_) {
+            fill(sorted, i, 2 * k);
+            tree_[k] = std::move(sorted[i++]);
+            fill(sorted, i, 2 * k + 1);
+        }
+    }
+
+    void layout(std::vector<T> sorted) {
+        n_ = sorted.size();
+        tree_.resize(n_ + 1);
+        size_type i = 0;
+        fill(sorted, i, 1);
+    }
+
+    // The descendants of `k` that are four levels down start at 16k.
+    // For elements of at most 4 bytes, that's one 64-byte cache line's
+    // worth; for larger elements we still prefetch the first line.
+    //
+    static constexpr size_type prefetch_stride = 16;
+
+    std::vector<T> tree_;
+    size_type n_ = 0;
+    [[no_unique_address]] Compare comp_;
+};
+
+// `EytzingerIterator` visits the implicit tree in-order, which is to say,
+// in sorted order. Its state is just an index `k` into the 1-based tree;
+// `k == 0` represents `end()`, and so a default-constructed iterator
+// compares equal to any `end()`.
+//
+template<class QualifiedType,
+         class UnqualifiedType /* = std::remove_cv_t<QualifiedType> */>
+struct EytzingerIterator
+{
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = UnqualifiedType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = QualifiedType*;
+    using reference = QualifiedType&;
+
+    EytzingerIterator() {}
+
+    template<class, class> friend class eytzinger_array;
+  private:
+    explicit EytzingerIterator(QualifiedType* tree, std::size_t k, std::size_t n)
+        : tree_(tree), k_(k), n_(n) {}
+  public:
+
+    EytzingerIterator(EytzingerIterator const&) = default;
+    EytzingerIterator& operator=(EytzingerIterator const&) = default;
+    EytzingerIterator(EytzingerIterator&&) noexcept = default;
+    EytzingerIterator& operator=(EytzingerIterator&&) = default;
+    ~EytzingerIterator() = default;
+
+    EytzingerIterator operator++(int) {
+        EytzingerIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    // The in-order successor of `k` is the leftmost node of its right
+    // subtree, if it has one. Otherwise, climb while `k` is a right child
+    // (its low bit is 1), and then climb once more.
+    //
+    EytzingerIterator& operator++() {
+        std::size_t r = 2 * k_ + 1;
+        if (r <= n_) {
+            int shift = std::bit_width(n_) - std::bit_width(r);
+            r <<= shift;
+            k_ = (r > n_) ? (r >> 1) : r;
+        } else {
+            k_ >>= std::countr_one(k_) + 1;
+        }
+        return *this;
+    }
+
+    reference operator*() const { return tree_[k_]; }
+
+    pointer operator->() const { return std::addressof(*(*this)); }
+
+    friend void swap(EytzingerIterator& a, EytzingerIterator& b) {
+        std::swap(a.tree_, b.tree_);
+        std::swap(a.k_, b.k_);
+        std::swap(a.n_, b.n_);
+    }
+
+    template<class QT>
+    bool operator==(EytzingerIterator<QT> const& other) const { return k_ == other.k_; }
+
+    template<class QT>
+    bool operator!=(EytzingerIterator<QT> const& other) const { return !(*this == other); }
+
+    template<class, class> friend struct EytzingerIterator;
+
+    operator EytzingerIterator<const UnqualifiedType>() const {
+        return EytzingerIterator<const UnqualifiedType>(tree_, k_, n_);
+    }
+
+  private:
+    QualifiedType* tree_ = nullptr;
+    std::size_t k_ = 0;
+    std::size_t n_ = 0;
+};
+
+static_assert(std::forward_iterator<eytzinger_array<int>::iterator>);
+static_assert(std::forward_iterator<eytzinger_array<int>::const_iterator>);
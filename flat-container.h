@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>  // size_t
+#include <iterator>  // distance, forward_iterator_tag, iterator_traits
+#include <type_traits>  // is_base_of_v
+
+// Helpers shared by `flat_set` and `flat_map`, which restructure their
+// underlying sequence containers in the same ways.
+
+// [flat.set.overview]p6, [flat.map.overview]p6: If an operation that
+// restructures the whole container throws, we can't know what state the
+// underlying containers were left in (or, for a map, whether the key and
+// mapped arrays still correspond); restore the invariant by clearing them.
+//
+template<class F, class... Containers>
+void guard_invariant(F f, Containers&... cs) {
+    try {
+        f();
+    } catch (...) {
+        (cs.clear(), ...);
+        throw;
+    }
+}
+
+// The length of [first, last) if that can be computed without consuming
+// the input, for reserving space ahead of a bulk insert; otherwise 0.
+//
+template<class InputIt>
+std::size_t maybe_distance(InputIt first, InputIt last) {
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>) {
+        return static_cast<std::size_t>(std::distance(first, last));
+    } else {
+        return 0;
+    }
+}
+
+// Returns an empty container that uses the same allocator as `c`, so
+// that a merge buffer allocates from the same place as the container
+// it replaces (e.g. a `shared_segment`).
+//
+template<class Container>
+Container empty_like(const Container& c) {
+    if constexpr (requires { c.get_allocator(); }) {
+        return Container(c.get_allocator());
+    } else {
+        return Container();
+    }
+}
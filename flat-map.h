@@ -0,0 +1,440 @@
+#pragma once
+
+#include <algorithm>  // lower_bound, upper_bound, stable_sort, unique
+#include <cstddef>  // ptrdiff_t
+#include <functional>  // less
+#include <initializer_list>  // initializer_list
+#include <iterator>  // make_move_iterator, random_access_iterator, random_access_iterator_tag
+#include <stdexcept>  // invalid_argument, out_of_range
+#include <type_traits>  // conditional_t, is_const_v, remove_cv_t
+#include <utility>  // forward, move, pair
+#include <vector>  // vector
+
+#include "arrow-proxy.h"
+#include "flat-container.h"
+#include "pair-reference.h"
+#include "reversible-container.h"
+#include "sorted-unique.h"
+
+template<
+    class QualifiedMap,
+    class UnqualifiedMap = std::remove_cv_t<QualifiedMap>,
+    class Reference = pair_reference<
+        const typename UnqualifiedMap::key_type&,
+        std::conditional_t<
+            std::is_const_v<QualifiedMap>,
+            const typename UnqualifiedMap::mapped_type,
+            typename UnqualifiedMap::mapped_type
+        >&
+    >
+> struct FlatMapIterator;
+
+// `flat_map` keeps its keys and its mapped values in two separate sequence
+// containers, sorted in parallel by key. Lookups (`find`, `lower_bound`,
+// `contains`, ...) binary-search the key array alone, so for a table of
+// small keys and large values, a lookup touches only a fraction of the cache
+// lines that an array of `std::pair<Key, T>` would. Iteration is a linear
+// scan over both arrays.
+//
+// As with `flat_set`, single-element insertion and erasure are O(n);
+// bulk insertion via `insert(sorted_unique, first, last)` is O(n + m).
+//
+template<class Key, class T, class Compare = std::less<Key>,
+         class KeyContainer = std::vector<Key>, class MappedContainer = std::vector<T>>
+class flat_map : public reversible_container<flat_map<Key, T, Compare, KeyContainer, MappedContainer>> {
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using key_compare = Compare;
+    using reference = pair_reference<const Key&, T&>;
+    using const_reference = pair_reference<const Key&, const T&>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using key_container_type = KeyContainer;
+    using mapped_container_type = MappedContainer;
+
+    using iterator = FlatMapIterator<flat_map>;
+    using const_iterator = FlatMapIterator<const flat_map>;
+    using reverse_iterator = reverse_iterator_t<iterator>;
+    using const_reverse_iterator = reverse_iterator_t<const_iterator>;
+
+    struct value_compare {
+        bool operator()(const_reference a, const_reference b) const { return comp(a.first, b.first); }
+        [[no_unique_address]] Compare comp;
+    };
+
+    flat_map() = default;
+    explicit flat_map(const Compare& comp) : comp_(comp) {}
+
+    flat_map(KeyContainer keys, MappedContainer values, const Compare& comp = Compare())
+        : comp_(comp)
+    {
+        if (keys.size() != values.size()) {
+            throw std::invalid_argument("flat_map: keys and values differ in size");
+        }
+        std::vector<value_type> tmp;
+        tmp.reserve(keys.size());
+        auto vit = values.begin();
+        for (auto& k : keys) {
+            tmp.emplace_back(std::move(k), std::move(*vit++));
+        }
+        insert(std::make_move_iterator(tmp.begin()), std::make_move_iterator(tmp.end()));
+    }
+
+    flat_map(sorted_unique_t, KeyContainer keys, MappedContainer values, const Compare& comp = Compare())
+        : keys_(std::move(keys)), values_(std::move(values)), comp_(comp)
+    {
+        if (keys_.size() != values_.size()) {
+            throw std::invalid_argument("flat_map: keys and values differ in size");
+        }
+    }
+
+    template<class InputIt>
+    flat_map(InputIt first, InputIt last, const Compare& comp = Compare()) : comp_(comp) {
+        insert(first, last);
+    }
+
+    template<class InputIt>
+    flat_map(sorted_unique_t, InputIt first, InputIt last, const Compare& comp = Compare()) : comp_(comp) {
+        insert(sorted_unique, first, last);
+    }
+
+    flat_map(std::initializer_list<value_type> il, const Compare& comp = Compare())
+        : flat_map(il.begin(), il.end(), comp) {}
+
+    iterator begin() { return iterator(keys_.cbegin(), values_.begin()); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(keys_.cbegin(), values_.cbegin()); }
+    iterator end() { return iterator(keys_.cend(), values_.end()); }
+    const_iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(keys_.cend(), values_.cend()); }
+
+    bool empty() const noexcept { return keys_.empty(); }
+    size_type size() const noexcept { return keys_.size(); }
+    size_type max_size() const noexcept { return std::min<size_type>(keys_.max_size(), values_.max_size()); }
+
+    key_compare key_comp() const { return comp_; }
+    value_compare value_comp() const { return value_compare{comp_}; }
+
+    const KeyContainer& keys() const noexcept { return keys_; }
+    const MappedContainer& values() const noexcept { return values_; }
+
+    T& operator[](const Key& k) { return try_emplace(k).first->second; }
+    T& operator[](Key&& k) { return try_emplace(std::move(k)).first->second; }
+
+    T& at(const Key& k) {
+        auto it = find(k);
+        if (it == end()) {
+            throw std::out_of_range("flat_map::at");
+        }
+        return it->second;
+    }
+    const T& at(const Key& k) const {
+        auto it = find(k);
+        if (it == end()) {
+            throw std::out_of_range("flat_map::at");
+        }
+        return it->second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& kv) { return try_emplace(kv.first, kv.second); }
+    std::pair<iterator, bool> insert(value_type&& kv) { return try_emplace(std::move(kv.first), std::move(kv.second)); }
+
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        value_type kv(std::forward<Args>(args)...);
+        return try_emplace(std::move(kv.first), std::move(kv.second));
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> try_emplace(K&& k, Args&&... args) {
+        auto kit = std::lower_bound(keys_.begin(), keys_.end(), k, comp_);
+        auto i = kit - keys_.begin();
+        if (kit != keys_.end() && !comp_(k, *kit)) {
+            return {begin() + i, false};
+        }
+        kit = keys_.insert(kit, std::forward<K>(k));
+        try {
+            values_.emplace(values_.begin() + i, std::forward<Args>(args)...);
+        } catch (...) {
+            keys_.erase(kit);
+            throw;
+        }
+        return {begin() + i, true};
+    }
+
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const Key& k, M&& obj) {
+        auto result = try_emplace(k, std::forward<M>(obj));
+        if (!result.second) {
+            result.first->second = std::forward<M>(obj);
+        }
+        return result;
+    }
+
+    // Sorts the new elements in a side buffer, drops duplicates, and then
+    // merges them in linearly. Among equivalent keys, the element already
+    // in the map wins; among equivalent new elements, the first one wins.
+    //
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        std::vector<value_type> tmp(first, last);
+        auto less = [&](const value_type& a, const value_type& b) { return comp_(a.first, b.first); };
+        auto equiv = [&](const value_type& a, const value_type& b) { return !less(a, b) && !less(b, a); };
+        std::stable_sort(tmp.begin(), tmp.end(), less);
+        tmp.erase(std::unique(tmp.begin(), tmp.end(), equiv), tmp.end());
+        insert(sorted_unique, std::make_move_iterator(tmp.begin()), std::make_move_iterator(tmp.end()));
+    }
+
+    // [flat.map.modifiers]: The input range must be sorted with respect
+    // to `key_comp()` and contain no duplicate keys. Runs in O(n + m):
+    // both arrays are rebuilt in a single merge pass, so no element is
+    // shifted more than once.
+    //
+    template<class InputIt>
+    void insert(sorted_unique_t, InputIt first, InputIt last) {
+        KeyContainer new_keys = empty_like(keys_);
+        MappedContainer new_values = empty_like(values_);
+        if constexpr (requires { new_keys.reserve(size_type()); new_values.reserve(size_type()); }) {
+            auto n = keys_.size() + maybe_distance(first, last);
+            new_keys.reserve(n);
+            new_values.reserve(n);
+        }
+        guard_invariant([&]() {
+            auto kit = keys_.begin();
+            auto vit = values_.begin();
+            for (; first != last; ++first) {
+                auto&& kv = *first;
+                while (kit != keys_.end() && comp_(*kit, kv.first)) {
+                    new_keys.push_back(std::move(*kit++));
+                    new_values.push_back(std::move(*vit++));
+                }
+                if (kit != keys_.end() && !comp_(kv.first, *kit)) {
+                    continue;
+                }
+                new_keys.push_back(std::forward<decltype(kv)>(kv).first);
+                new_values.push_back(std::forward<decltype(kv)>(kv).second);
+            }
+            new_keys.insert(new_keys.end(), std::make_move_iterator(kit), std::make_move_iterator(keys_.end()));
+            new_values.insert(new_values.end(), std::make_move_iterator(vit), std::make_move_iterator(values_.end()));
+        }, keys_, values_);
+        keys_ = std::move(new_keys);
+        values_ = std::move(new_values);
+    }
+
+    void insert(std::initializer_list<value_type> il) { insert(il.begin(), il.end()); }
+    void insert(sorted_unique_t, std::initializer_list<value_type> il) { insert(sorted_unique, il.begin(), il.end()); }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+    iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+    iterator erase(const_iterator first, const_iterator last) {
+        auto i = first - cbegin();
+        auto j = last - cbegin();
+        keys_.erase(keys_.begin() + i, keys_.begin() + j);
+        values_.erase(values_.begin() + i, values_.begin() + j);
+        return begin() + i;
+    }
+    size_type erase(const Key& k) {
+        auto it = find(k);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    void clear() noexcept {
+        keys_.clear();
+        values_.clear();
+    }
+
+    // [flat.map.modifiers]: `extract` and `replace` give the user direct
+    // access to the underlying containers, e.g. to serialize them, or to
+    // build them elsewhere and adopt them without copying.
+    //
+    struct containers {
+        KeyContainer keys;
+        MappedContainer values;
+    };
+
+    containers extract() && {
+        containers result{std::move(keys_), std::move(values_)};
+        clear();
+        return result;
+    }
+
+    void replace(KeyContainer&& keys, MappedContainer&& values) {
+        keys_ = std::move(keys);
+        values_ = std::move(values);
+    }
+
+    void swap(flat_map& other) noexcept {
+        using std::swap;
+        swap(keys_, other.keys_);
+        swap(values_, other.values_);
+        swap(comp_, other.comp_);
+    }
+    friend void swap(flat_map& a, flat_map& b) noexcept { a.swap(b); }
+
+    // Lookups touch nothing but the key array; the mapped array is indexed
+    // only once the position is known. The templated overloads participate
+    // only when `Compare::is_transparent` is defined.
+    //
+    iterator lower_bound(const Key& k) { return at_key(lower_bound_impl(k)); }
+    const_iterator lower_bound(const Key& k) const { return at_key(lower_bound_impl(k)); }
+    iterator upper_bound(const Key& k) { return at_key(upper_bound_impl(k)); }
+    const_iterator upper_bound(const Key& k) const { return at_key(upper_bound_impl(k)); }
+    std::pair<iterator, iterator> equal_range(const Key& k) { return {lower_bound(k), upper_bound(k)}; }
+    std::pair<const_iterator, const_iterator> equal_range(const Key& k) const { return {lower_bound(k), upper_bound(k)}; }
+    iterator find(const Key& k) { return at_key(find_impl(k)); }
+    const_iterator find(const Key& k) const { return at_key(find_impl(k)); }
+    bool contains(const Key& k) const { return find_impl(k) != keys_.end(); }
+    size_type count(const Key& k) const { return contains(k) ? 1 : 0; }
+
+    template<class K> requires requires { typename Compare::is_transparent; }
+    iterator lower_bound(const K& k) { return at_key(lower_bound_impl(k)); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    const_iterator lower_bound(const K& k) const { return at_key(lower_bound_impl(k)); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    iterator upper_bound(const K& k) { return at_key(upper_bound_impl(k)); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    const_iterator upper_bound(const K& k) const { return at_key(upper_bound_impl(k)); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    iterator find(const K& k) { return at_key(find_impl(k)); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    const_iterator find(const K& k) const { return at_key(find_impl(k)); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    bool contains(const K& k) const { return find_impl(k) != keys_.end(); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    size_type count(const K& k) const { return contains(k) ? 1 : 0; }
+
+    friend bool operator==(const flat_map& a, const flat_map& b) {
+        return a.keys_ == b.keys_ && a.values_ == b.values_;
+    }
+
+  private:
+    using key_iterator = typename KeyContainer::const_iterator;
+
+    template<class K>
+    key_iterator lower_bound_impl(const K& k) const { return std::lower_bound(keys_.begin(), keys_.end(), k, comp_); }
+
+    template<class K>
+    key_iterator upper_bound_impl(const K& k) const { return std::upper_bound(keys_.begin(), keys_.end(), k, comp_); }
+
+    template<class K>
+    key_iterator find_impl(const K& k) const {
+        auto it = lower_bound_impl(k);
+        return (it != keys_.end() && !comp_(k, *it)) ? it : keys_.end();
+    }
+
+    iterator at_key(key_iterator kit) { return begin() + (kit - keys_.cbegin()); }
+    const_iterator at_key(key_iterator kit) const { return cbegin() + (kit - keys_.cbegin()); }
+
+    KeyContainer keys_;
+    MappedContainer values_;
+    [[no_unique_address]] Compare comp_;
+};
+
+// `FlatMapIterator` holds one iterator into each of the two parallel
+// arrays. Since there is no `std::pair<Key, T>` object anywhere in memory
+// for it to refer to, its `reference` type is the proxy
+// `pair_reference<const Key&, T&>` and its `pointer` type is an `arrow_proxy`.
+//
+// Notice that `FlatMapIterator<const M>::value_type` is `M::value_type`,
+// following the precedent set by the standard library containers.
+//
+template<class QualifiedMap,
+         class UnqualifiedMap /* = std::remove_cv_t<QualifiedMap> */,
+         class Reference /* = pair_reference<const Key&, T&> */>
+struct FlatMapIterator
+{
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename UnqualifiedMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = arrow_proxy<Reference>;
+    using reference = Reference;
+
+    FlatMapIterator() {}
+
+    friend UnqualifiedMap;
+    template<class, class, class> friend struct FlatMapIterator;
+  private:
+    using key_iterator = typename UnqualifiedMap::key_container_type::const_iterator;
+    using mapped_iterator = std::conditional_t<
+        std::is_const_v<QualifiedMap>,
+        typename UnqualifiedMap::mapped_container_type::const_iterator,
+        typename UnqualifiedMap::mapped_container_type::iterator
+    >;
+
+    explicit FlatMapIterator(key_iterator k, mapped_iterator m) : k_(k), m_(m) {}
+  public:
+
+    FlatMapIterator(FlatMapIterator const&) = default;
+    FlatMapIterator& operator=(FlatMapIterator const&) = default;
+    FlatMapIterator(FlatMapIterator&&) noexcept = default;
+    FlatMapIterator& operator=(FlatMapIterator&&) = default;
+    ~FlatMapIterator() = default;
+
+    FlatMapIterator operator++(int) {
+        FlatMapIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    FlatMapIterator operator--(int) {
+        FlatMapIterator tmp = *this;
+        --(*this);
+        return tmp;
+    }
+
+    FlatMapIterator& operator++() { ++k_; ++m_; return *this; }
+    FlatMapIterator& operator--() { --k_; --m_; return *this; }
+
+    FlatMapIterator& operator+=(difference_type n) { k_ += n; m_ += n; return *this; }
+    FlatMapIterator& operator-=(difference_type n) { k_ -= n; m_ -= n; return *this; }
+    FlatMapIterator operator+(difference_type n) const { FlatMapIterator tmp = *this; return tmp += n; }
+    FlatMapIterator operator-(difference_type n) const { FlatMapIterator tmp = *this; return tmp -= n; }
+    friend FlatMapIterator operator+(difference_type n, const FlatMapIterator& it) { return it + n; }
+
+    template<class QM>
+    difference_type operator-(FlatMapIterator<QM> const& other) const { return k_ - other.k_; }
+
+    reference operator*() const { return reference(*k_, *m_); }
+    reference operator[](difference_type n) const { return *(*this + n); }
+    pointer operator->() const { return pointer{*(*this)}; }
+
+    friend void swap(FlatMapIterator& a, FlatMapIterator& b) {
+        using std::swap;
+        swap(a.k_, b.k_);
+        swap(a.m_, b.m_);
+    }
+
+    // The two arrays always move in lockstep, so comparing the key
+    // iterators alone suffices.
+    //
+    template<class QM>
+    bool operator==(FlatMapIterator<QM> const& other) const { return k_ == other.k_; }
+    template<class QM>
+    bool operator!=(FlatMapIterator<QM> const& other) const { return !(*this == other); }
+    template<class QM>
+    bool operator<(FlatMapIterator<QM> const& other) const { return k_ < other.k_; }
+    template<class QM>
+    bool operator>(FlatMapIterator<QM> const& other) const { return other < *this; }
+    template<class QM>
+    bool operator<=(FlatMapIterator<QM> const& other) const { return !(other < *this); }
+    template<class QM>
+    bool operator>=(FlatMapIterator<QM> const& other) const { return !(*this < other); }
+
+    operator FlatMapIterator<const UnqualifiedMap>() const {
+        return FlatMapIterator<const UnqualifiedMap>(k_, m_);
+    }
+
+  private:
+    key_iterator k_{};
+    mapped_iterator m_{};
+};
+
+static_assert(std::random_access_iterator<flat_map<int, int>::iterator>);
+static_assert(std::random_access_iterator<flat_map<int, int>::const_iterator>);
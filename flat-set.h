@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>  // lower_bound, upper_bound, stable_sort, unique
+#include <functional>  // less
+#include <initializer_list>  // initializer_list
+#include <iterator>  // make_move_iterator
+#include <utility>  // move, pair
+#include <vector>  // vector
+
+#include "flat-container.h"
+#include "reversible-container.h"
+#include "sorted-unique.h"
+
+// `flat_set` keeps its keys sorted in a single contiguous sequence container.
+// Lookups are binary searches over that one array, which touch O(log n)
+// cache lines instead of chasing O(log n) heap-allocated tree nodes, and
+// iteration is a linear scan. The price is O(n) single-element insertion
+// and erasure, so this container is the right choice for tables that are
+// built once (or in bulk) and then read many times.
+//
+// Bulk insertion via `insert(sorted_unique, first, last)` merges the new
+// keys into the existing ones in a single O(n + m) pass.
+//
+template<class Key, class Compare = std::less<Key>, class KeyContainer = std::vector<Key>>
+class flat_set : public reversible_container<flat_set<Key, Compare, KeyContainer>> {
+  public:
+    using key_type = Key;
+    using value_type = Key;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = typename KeyContainer::size_type;
+    using difference_type = typename KeyContainer::difference_type;
+    using container_type = KeyContainer;
+
+    // [associative.reqmts.general]p6: Modifying a key in place would break
+    // the sorted invariant, so (as with std::set) `iterator` is a constant
+    // iterator too.
+    //
+    using iterator = typename KeyContainer::const_iterator;
+    using const_iterator = typename KeyContainer::const_iterator;
+    using reverse_iterator = contiguous_reverse_iterator_t<iterator>;
+    using const_reverse_iterator = contiguous_reverse_iterator_t<const_iterator>;
+
+    flat_set() = default;
+    explicit flat_set(const Compare& comp) : comp_(comp) {}
+
+    explicit flat_set(KeyContainer keys, const Compare& comp = Compare())
+        : keys_(std::move(keys)), comp_(comp)
+    {
+        sort_and_unique(keys_.begin());
+    }
+
+    flat_set(sorted_unique_t, KeyContainer keys, const Compare& comp = Compare())
+        : keys_(std::move(keys)), comp_(comp) {}
+
+    template<class InputIt>
+    flat_set(InputIt first, InputIt last, const Compare& comp = Compare()) : comp_(comp) {
+        insert(first, last);
+    }
+
+    template<class InputIt>
+    flat_set(sorted_unique_t, InputIt first, InputIt last, const Compare& comp = Compare())
+        : keys_(first, last), comp_(comp) {}
+
+    flat_set(std::initializer_list<Key> il, const Compare& comp = Compare())
+        : flat_set(il.begin(), il.end(), comp) {}
+
+    iterator begin() const { return keys_.begin(); }
+    const_iterator cbegin() const { return keys_.cbegin(); }
+    iterator end() const { return keys_.end(); }
+    const_iterator cend() const { return keys_.cend(); }
+
+    bool empty() const noexcept { return keys_.empty(); }
+    size_type size() const noexcept { return keys_.size(); }
+    size_type max_size() const noexcept { return keys_.max_size(); }
+
+    key_compare key_comp() const { return comp_; }
+    value_compare value_comp() const { return comp_; }
+
+    std::pair<iterator, bool> insert(const Key& k) { return emplace_hint_impl(lower_bound(k), k); }
+    std::pair<iterator, bool> insert(Key&& k) { return emplace_hint_impl(lower_bound(k), std::move(k)); }
+
+    // Appends the new keys, sorts only the appended part, and merges.
+    // Among equivalent keys, the one already in the set wins; among
+    // equivalent new keys, the first one wins.
+    //
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        auto old_size = keys_.size();
+        keys_.insert(keys_.end(), first, last);
+        sort_and_unique(keys_.begin() + old_size);
+    }
+
+    // [flat.set.modifiers]: The input range must be sorted with respect
+    // to `key_comp()` and contain no duplicates. Runs in O(n + m).
+    //
+    template<class InputIt>
+    void insert(sorted_unique_t, InputIt first, InputIt last) {
+        KeyContainer merged = empty_like(keys_);
+        if constexpr (requires { merged.reserve(size_type()); }) {
+            merged.reserve(keys_.size() + maybe_distance(first, last));
+        }
+        guard_invariant([&]() {
+            auto it = keys_.begin();
+            auto e = keys_.end();
+            while (first != last && it != e) {
+                if (comp_(*it, *first)) {
+                    merged.push_back(std::move(*it++));
+                } else if (comp_(*first, *it)) {
+                    merged.push_back(*first++);
+                } else {
+                    merged.push_back(std::move(*it++));
+                    ++first;
+                }
+            }
+            merged.insert(merged.end(), std::make_move_iterator(it), std::make_move_iterator(e));
+            merged.insert(merged.end(), first, last);
+        }, keys_);
+        keys_ = std::move(merged);
+    }
+
+    void insert(std::initializer_list<Key> il) { insert(il.begin(), il.end()); }
+    void insert(sorted_unique_t, std::initializer_list<Key> il) { insert(sorted_unique, il.begin(), il.end()); }
+
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        Key k(std::forward<Args>(args)...);
+        return emplace_hint_impl(lower_bound(k), std::move(k));
+    }
+
+    iterator erase(const_iterator pos) { return keys_.erase(pos); }
+    iterator erase(const_iterator first, const_iterator last) { return keys_.erase(first, last); }
+    size_type erase(const Key& k) {
+        auto [first, last] = equal_range(k);
+        auto n = static_cast<size_type>(last - first);
+        keys_.erase(first, last);
+        return n;
+    }
+
+    void clear() noexcept { keys_.clear(); }
+
+    // [flat.set.modifiers]: `extract` and `replace` give the user direct
+    // access to the underlying container, e.g. to serialize it, or to
+    // build it elsewhere and adopt it without copying.
+    //
+    KeyContainer extract() && {
+        KeyContainer result = std::move(keys_);
+        keys_.clear();
+        return result;
+    }
+    void replace(KeyContainer&& keys) { keys_ = std::move(keys); }
+
+    const KeyContainer& keys() const noexcept { return keys_; }
+
+    void swap(flat_set& other) noexcept {
+        using std::swap;
+        swap(keys_, other.keys_);
+        swap(comp_, other.comp_);
+    }
+    friend void swap(flat_set& a, flat_set& b) noexcept { a.swap(b); }
+
+    // Lookups touch nothing but the key array. The templated overloads
+    // participate only when `Compare::is_transparent` is defined, so that
+    // (for example) a `flat_set<std::string, std::less<>>` can be searched
+    // with a `std::string_view` without materializing a `std::string`.
+    //
+    iterator lower_bound(const Key& k) const { return std::lower_bound(keys_.begin(), keys_.end(), k, comp_); }
+    iterator upper_bound(const Key& k) const { return std::upper_bound(keys_.begin(), keys_.end(), k, comp_); }
+    std::pair<iterator, iterator> equal_range(const Key& k) const { return {lower_bound(k), upper_bound(k)}; }
+    iterator find(const Key& k) const { return find_impl(k); }
+    bool contains(const Key& k) const { return find(k) != end(); }
+    size_type count(const Key& k) const { return contains(k) ? 1 : 0; }
+
+    template<class K> requires requires { typename Compare::is_transparent; }
+    iterator lower_bound(const K& k) const { return std::lower_bound(keys_.begin(), keys_.end(), k, comp_); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    iterator upper_bound(const K& k) const { return std::upper_bound(keys_.begin(), keys_.end(), k, comp_); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    std::pair<iterator, iterator> equal_range(const K& k) const { return {lower_bound(k), upper_bound(k)}; }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    iterator find(const K& k) const { return find_impl(k); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    bool contains(const K& k) const { return find(k) != end(); }
+    template<class K> requires requires { typename Compare::is_transparent; }
+    size_type count(const K& k) const { return contains(k) ? 1 : 0; }
+
+    friend bool operator==(const flat_set& a, const flat_set& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+  private:
+    template<class K>
+    iterator find_impl(const K& k) const {
+        auto it = lower_bound(k);
+        return (it != end() && !comp_(k, *it)) ? it : end();
+    }
+
+    template<class K>
+    std::pair<iterator, bool> emplace_hint_impl(iterator pos, K&& k) {
+        if (pos != end() && !comp_(k, *pos)) {
+            return {pos, false};
+        }
+        return {keys_.insert(pos, std::forward<K>(k)), true};
+    }
+
+    // Sorts [mid, end), drops duplicates (within the new keys and against
+    // the old ones), and merges the result into the already-sorted [begin, mid).
+    //
+    void sort_and_unique(typename KeyContainer::iterator mid) {
+        guard_invariant([&]() {
+            auto equiv = [&](const Key& a, const Key& b) { return !comp_(a, b) && !comp_(b, a); };
+            std::stable_sort(mid, keys_.end(), comp_);
+            keys_.erase(std::unique(mid, keys_.end(), equiv), keys_.end());
+            std::inplace_merge(keys_.begin(), mid, keys_.end(), comp_);
+            keys_.erase(std::unique(keys_.begin(), keys_.end(), equiv), keys_.end());
+        }, keys_);
+    }
+
+    KeyContainer keys_;
+    [[no_unique_address]] Compare comp_;
+};
@@ -1,20 +1,13 @@
 #pragma once
 
 #include <cstddef>  // ptrdiff_t
-#include <iterator>  // iterator, forward_iterator_tag
-#include <memory>  // addressof
+#include <iterator>  // forward_iterator, forward_iterator_tag
+#include <memory>  // pointer_traits
 #include <type_traits>  // remove_cv_t
 
 template<
     class QualifiedType,
-    class UnqualifiedType = std::remove_cv_t<QualifiedType>,
-    class IteratorBase = std::iterator<
-        std::forward_iterator_tag,
-        UnqualifiedType,
-        std::ptrdiff_t,
-        QualifiedType*,
-        QualifiedType&
-    >
+    class UnqualifiedType = std::remove_cv_t<QualifiedType>
 > struct ForwardVectorIterator;
 
 // This is just a simple container class for illustrative purposes.
@@ -35,8 +28,19 @@ class ForwardVector {
     const_iterator cend() const { return const_iterator(data+10); }
 };
 
-// Inheriting from std::iterator ensures that there exists an appropriate
-// specialization of the std::iterator_traits class template.
+// [iterator.traits]p2: Declaring the member types `iterator_category`,
+// `value_type`, `difference_type`, `pointer` and `reference` ensures that
+// there exists an appropriate specialization of the std::iterator_traits
+// class template. (Inheriting from `std::iterator` used to do the same,
+// but it is deprecated since C++17, and it can't declare the next one.)
+//
+// [iterator.concepts.general]p1: The C++20 iterator concepts, and hence the
+// `std::ranges` algorithms, determine an iterator's category from its
+// `iterator_concept` member type if it has one. Without it, they fall back
+// on `iterator_category`, which (being about the C++17 requirements) may
+// understate what the iterator can do; for example, an iterator whose
+// `reference` is not a true reference can't be a C++17 forward iterator.
+// Declare `iterator_concept` so that the strongest category is detected.
 //
 // Notice that `ForwardVectorIterator<const T>::value_type` is `T`,
 // not `const T`. This follows the precedent set by the standard library
@@ -49,12 +53,15 @@ class ForwardVector {
 // and a constant iterator.
 //
 template<class QualifiedType,
-         class UnqualifiedType /* = std::remove_cv_t<QualifiedType> */,
-         class IteratorBase /* = std::iterator<...> */ >
-struct ForwardVectorIterator : IteratorBase
+         class UnqualifiedType /* = std::remove_cv_t<QualifiedType> */>
+struct ForwardVectorIterator
 {
-    using typename IteratorBase::reference;
-    using typename IteratorBase::pointer;
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = UnqualifiedType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = QualifiedType*;
+    using reference = QualifiedType&;
 
     // [forward.iterators]p1.2: MyForwardIterator must be DefaultConstructible,
     // which implies that a default-constructed MyForwardIterator must be able to be
@@ -164,10 +171,13 @@ struct ForwardVectorIterator : IteratorBase
         // perform your custom dereference operation
     }
 
-    // If you know that `value_type` doesn't overload the unary `&` operator,
-    // feel free to use `&` instead of `std::addressof` here.
+    // For a raw pointer, `std::pointer_traits<pointer>::pointer_to` is just
+    // `std::addressof`. Going through it keeps this line correct if your
+    // container takes an allocator and you replace `QualifiedType*` above
+    // with the allocator's (possibly fancy) pointer type, rebound to
+    // `QualifiedType`; for example, `offset_ptr<QualifiedType>`.
     //
-    pointer operator->() const { return std::addressof(*(*this)); }
+    pointer operator->() const { return std::pointer_traits<pointer>::pointer_to(*(*this)); }
 
     // [iterator.iterators]p2.1: Iterators must be swappable.
     // Placing this `friend` function inline is the easiest way to ensure
@@ -200,6 +210,32 @@ struct ForwardVectorIterator : IteratorBase
     template<class QT>
     bool operator!=(ForwardVectorIterator<QT> const& other) const { return !(*this == other); }
 
+    // [iterator.concept.sentinel]: If your container can't cheaply produce
+    // its end iterator (say, the range ends at a terminator that nobody has
+    // looked for yet), its `end()` may return a distinct *sentinel* type
+    // instead, provided that the iterator and the sentinel are comparable:
+    //
+    //   friend bool operator==(ForwardVectorIterator const& it, MySentinel) { ... }
+    //
+    // C++20 synthesizes `s == it`, `it != s` and `s != it` from that one
+    // function. Then every loop compares against the terminating condition
+    // directly, rather than against a precomputed position. See
+    // `sentinels.h` for some ready-made sentinels. (Pre-C++20 algorithms
+    // still require `begin()` and `end()` to have the same type.)
+    //
+
+    // The parallel algorithms in `parallel.h` split a range by advancing an
+    // iterator about halfway through it, which for a non-random-access
+    // iterator means one `operator++` per element skipped. If your container
+    // stores its elements in blocks, chunks or segments whose sizes it knows,
+    // it can do better by skipping whole blocks at a time:
+    //
+    //   friend void split_advance(ForwardVectorIterator& it, difference_type n) { ... }
+    //
+    // This advances `it` by exactly `n` elements; see `BtreeMapIterator` for
+    // an example.
+    //
+
     // [container.requirements.general] Table 96: A plain iterator must be
     // convertible (i.e., implicitly convertible) to a const_iterator.
     // This means you must provide either a constructor or a conversion operator.
@@ -224,3 +260,11 @@ struct ForwardVectorIterator : IteratorBase
   private:
     // declare your custom data members
 };
+
+// [iterator.concept.forward]: Checking the C++20 concept right here means
+// the compiler tells you what's missing as soon as you've made a mistake.
+//
+#if not ITERATOR_IS_MOVEONLY
+static_assert(std::forward_iterator<ForwardVectorIterator<int>>);
+static_assert(std::forward_iterator<ForwardVectorIterator<const int>>);
+#endif
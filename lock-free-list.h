@@ -0,0 +1,295 @@
+#pragma once
+
+#include <atomic>  // atomic, memory_order
+#include <cstddef>  // ptrdiff_t, size_t
+#include <iterator>  // forward_iterator, forward_iterator_tag
+#include <mutex>  // defer_lock
+#include <optional>  // optional
+#include <utility>  // exchange, forward, in_place, in_place_t, move
+
+#include "memory-reclamation.h"
+
+template<class T> struct LockFreeListIterator;
+
+// `lock_free_stack<T>` (Treiber, "Systems programming: coping with
+// parallelism", 1986) and `lock_free_queue<T>` (Michael and Scott, "Simple,
+// fast, and practical non-blocking and blocking concurrent queue
+// algorithms", 1996) are unbounded, lock-free, multi-producer and
+// multi-consumer singly linked lists, which any number of threads may push
+// to, pop from, and iterate over at once.
+//
+// Popped nodes are retired to an `epoch_domain` rather than deleted, and
+// every operation that dereferences a shared node runs inside an
+// `epoch_guard`. That also rules out the ABA problem: a node can't be freed,
+// and its address reused for a new node, while a thread that read its
+// address is still in a critical section, so a `compare_exchange` that
+// succeeds really did see the same node.
+//
+// Their iterators are constant forward iterators, each of which holds an
+// `epoch_guard` until it reaches the end. `begin()` fixes a snapshot: the
+// iterator visits the elements that were in the container at that moment,
+// in pop order (for the queue, possibly followed by some that were pushed
+// while `begin()` ran), even if they are popped meanwhile; and it never
+// visits elements pushed later. Holding an iterator holds up reclamation
+// in its whole domain, so don't keep one around for long.
+//
+// An iterator copied or moved to another thread takes a guard of that
+// thread, at the original's epoch, so `parallel_for_each` and the other
+// algorithms of parallel.h can split a snapshot among a pool's workers.
+// Each iterator must still be destroyed on the thread where it was made.
+//
+// Because an element being popped may still be read by an iterator, `pop`
+// copies it out rather than moving it.
+//
+template<class T>
+struct lock_free_node {
+    lock_free_node() = default;
+
+    template<class... Args>
+    explicit lock_free_node(std::in_place_t, Args&&... args) : value(std::in_place, std::forward<Args>(args)...) {}
+
+    // Empty only for the queue's initial dummy node.
+    std::optional<T> value;
+    std::atomic<lock_free_node*> next = nullptr;
+};
+
+template<class T>
+class lock_free_stack {
+    using node = lock_free_node<T>;
+
+  public:
+    using value_type = T;
+    using const_reference = const T&;
+    using iterator = LockFreeListIterator<T>;
+    using const_iterator = LockFreeListIterator<T>;
+
+    lock_free_stack() : lock_free_stack(epoch_domain::default_domain()) {}
+    explicit lock_free_stack(epoch_domain& domain) : domain_(&domain) {}
+
+    lock_free_stack(const lock_free_stack&) = delete;
+    lock_free_stack& operator=(const lock_free_stack&) = delete;
+
+    // Not thread-safe.
+    ~lock_free_stack() {
+        node *n = head_.load(std::memory_order_acquire);
+        while (n != nullptr) {
+            delete std::exchange(n, n->next.load(std::memory_order_relaxed));
+        }
+    }
+
+    iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const {
+        epoch_guard guard(*domain_);
+        node *h = head_.load(std::memory_order_acquire);
+        return (h == nullptr) ? const_iterator() : const_iterator(std::move(guard), h, nullptr);
+    }
+    iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(); }
+
+    // A snapshot, like iteration.
+    bool empty() const noexcept { return head_.load(std::memory_order_acquire) == nullptr; }
+
+    // Pushing dereferences no shared node, so it needs no guard.
+    //
+    template<class... Args>
+    void emplace(Args&&... args) {
+        node *n = new node(std::in_place, std::forward<Args>(args)...);
+        node *h = head_.load(std::memory_order_relaxed);
+        do {
+            n->next.store(h, std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(h, n, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    bool try_pop(T& out) {
+        epoch_guard guard(*domain_);
+        node *h = head_.load(std::memory_order_acquire);
+        while (h != nullptr &&
+               !head_.compare_exchange_weak(h, h->next.load(std::memory_order_relaxed),
+                                            std::memory_order_acquire, std::memory_order_acquire)) {
+        }
+        if (h == nullptr) {
+            return false;
+        }
+        out = *h->value;
+        domain_->retire(h);
+        return true;
+    }
+
+  private:
+    epoch_domain *domain_;
+    std::atomic<node*> head_ = nullptr;
+};
+
+template<class T>
+class lock_free_queue {
+    using node = lock_free_node<T>;
+
+  public:
+    using value_type = T;
+    using const_reference = const T&;
+    using iterator = LockFreeListIterator<T>;
+    using const_iterator = LockFreeListIterator<T>;
+
+    lock_free_queue() : lock_free_queue(epoch_domain::default_domain()) {}
+    explicit lock_free_queue(epoch_domain& domain) : domain_(&domain) {
+        node *dummy = new node;
+        head_.store(dummy, std::memory_order_relaxed);
+        tail_.store(dummy, std::memory_order_relaxed);
+    }
+
+    lock_free_queue(const lock_free_queue&) = delete;
+    lock_free_queue& operator=(const lock_free_queue&) = delete;
+
+    // Not thread-safe.
+    ~lock_free_queue() {
+        node *n = head_.load(std::memory_order_acquire);
+        while (n != nullptr) {
+            delete std::exchange(n, n->next.load(std::memory_order_relaxed));
+        }
+    }
+
+    // The head is always a dummy node, whose value (if any) has already been
+    // popped. The tail may lag one or more nodes behind the true last node;
+    // the snapshot ends at whichever node was last when we looked, which is
+    // never before the head.
+    //
+    iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const {
+        epoch_guard guard(*domain_);
+        node *first = head_.load(std::memory_order_acquire)->next.load(std::memory_order_acquire);
+        if (first == nullptr) {
+            return const_iterator();
+        }
+        node *last = tail_.load(std::memory_order_acquire);
+        while (node *next = last->next.load(std::memory_order_acquire)) {
+            last = next;
+        }
+        return const_iterator(std::move(guard), first, last);
+    }
+    iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(); }
+
+    bool empty() const {
+        epoch_guard guard(*domain_);
+        return head_.load(std::memory_order_acquire)->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    template<class... Args>
+    void emplace(Args&&... args) {
+        node *n = new node(std::in_place, std::forward<Args>(args)...);
+        epoch_guard guard(*domain_);
+        for (;;) {
+            node *t = tail_.load(std::memory_order_acquire);
+            node *next = t->next.load(std::memory_order_acquire);
+            if (next != nullptr) {
+                // Help the enqueuer that linked `next` to swing the tail.
+                tail_.compare_exchange_weak(t, next, std::memory_order_release, std::memory_order_relaxed);
+            } else if (t->next.compare_exchange_weak(next, n, std::memory_order_release, std::memory_order_relaxed)) {
+                tail_.compare_exchange_strong(t, n, std::memory_order_release, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    // The popped node becomes the new dummy; the old dummy is retired.
+    //
+    bool try_pop(T& out) {
+        epoch_guard guard(*domain_);
+        for (;;) {
+            node *h = head_.load(std::memory_order_acquire);
+            node *next = h->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                return false;
+            }
+            node *t = tail_.load(std::memory_order_acquire);
+            if (h == t) {
+                // Don't let the head pass the tail.
+                tail_.compare_exchange_weak(t, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (head_.compare_exchange_weak(h, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                out = *next->value;
+                domain_->retire(h);
+                return true;
+            }
+        }
+    }
+
+  private:
+    static constexpr std::size_t cache_line = 64;
+
+    epoch_domain *domain_;
+    alignas(cache_line) std::atomic<node*> head_ = nullptr;
+    alignas(cache_line) std::atomic<node*> tail_ = nullptr;
+};
+
+// A constant iterator over a snapshot of a `lock_free_stack` or
+// `lock_free_queue`. It stops after `last_`, or at a null `next` if `last_`
+// is null. An iterator that reaches the end releases its guard, so that
+// `it == end()` compares equal however the end was reached.
+//
+template<class T>
+struct LockFreeListIterator
+{
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    LockFreeListIterator() {}
+
+    template<class> friend class lock_free_stack;
+    template<class> friend class lock_free_queue;
+  private:
+    explicit LockFreeListIterator(epoch_guard guard, const lock_free_node<T> *node, const lock_free_node<T> *last) :
+        guard_(std::move(guard)), node_(node), last_(last) {}
+  public:
+
+    LockFreeListIterator(LockFreeListIterator const&) = default;
+    LockFreeListIterator& operator=(LockFreeListIterator const&) = default;
+    LockFreeListIterator(LockFreeListIterator&&) noexcept = default;
+    LockFreeListIterator& operator=(LockFreeListIterator&&) = default;
+    ~LockFreeListIterator() = default;
+
+    LockFreeListIterator operator++(int) {
+        LockFreeListIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    LockFreeListIterator& operator++() {
+        node_ = (node_ == last_) ? nullptr : node_->next.load(std::memory_order_acquire);
+        if (node_ == nullptr) {
+            *this = LockFreeListIterator();
+        }
+        return *this;
+    }
+
+    reference operator*() const { return *node_->value; }
+    pointer operator->() const { return &*node_->value; }
+
+    friend void swap(LockFreeListIterator& a, LockFreeListIterator& b) {
+        LockFreeListIterator tmp = std::move(a);
+        a = std::move(b);
+        b = std::move(tmp);
+    }
+
+    bool operator==(LockFreeListIterator const& other) const { return node_ == other.node_; }
+    bool operator!=(LockFreeListIterator const& other) const { return !(*this == other); }
+
+  private:
+    epoch_guard guard_{std::defer_lock};
+    const lock_free_node<T> *node_ = nullptr;
+    const lock_free_node<T> *last_ = nullptr;
+};
+
+static_assert(std::forward_iterator<lock_free_stack<int>::iterator>);
+static_assert(std::forward_iterator<lock_free_queue<int>::const_iterator>);
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>  // fill, max
+#include <cerrno>  // errno
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint32_t, uint64_t
+#include <new>  // launder
+#include <stdexcept>  // out_of_range
+#include <string>  // string
+#include <system_error>  // errc, generic_category, make_error_code, system_error
+#include <type_traits>  // is_trivially_copyable_v
+#include <utility>  // exchange, forward, move, swap
+
+#include <fcntl.h>  // open, O_CLOEXEC, O_CREAT, O_RDWR
+#include <sys/mman.h>  // mmap, mremap, msync, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>  // close, ftruncate
+
+#include "reversible-container.h"
+
+// `mapped_vector<T>` is a vector whose storage is a memory-mapped file.
+// The file holds a small header followed by the elements themselves, in
+// their in-memory representation, so reopening an existing file is O(1):
+// it maps the file back in and checks the header, with no deserialization.
+// That's why `T` must be trivially copyable.
+//
+// The file is not portable between platforms with different
+// representations of `T` (endianness, padding, `sizeof(T)`); the header
+// records `sizeof(T)` and `alignof(T)` and opening a file that disagrees
+// fails.
+//
+// Growth extends the file with `ftruncate` and the mapping with `mremap`
+// (on Linux; elsewhere it falls back to unmapping and mapping again).
+// Either way, growing invalidates every pointer, reference and iterator
+// into the vector, just as for `std::vector`.
+//
+// Changes reach the file through the page cache whenever the kernel
+// decides to write them back. `sync()` forces them out with `msync`.
+//
+// Errors from the system calls are reported as `std::system_error`.
+//
+template<class T>
+class mapped_vector : public reversible_container<mapped_vector<T>> {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = contiguous_reverse_iterator_t<iterator>;
+    using const_reverse_iterator = contiguous_reverse_iterator_t<const_iterator>;
+
+    // Opens the file at `path`, creating an empty vector there if the file
+    // doesn't exist or is empty.
+    //
+    explicit mapped_vector(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ == -1) {
+            throw_errno("mapped_vector: open");
+        }
+        try {
+            struct stat st;
+            if (::fstat(fd_, &st) == -1) {
+                throw_errno("mapped_vector: fstat");
+            }
+            if (st.st_size == 0) {
+                create();
+            } else {
+                open_existing(size_type(st.st_size));
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    mapped_vector(mapped_vector&& rhs) noexcept :
+        fd_(std::exchange(rhs.fd_, -1)),
+        base_(std::exchange(rhs.base_, nullptr)),
+        mapped_bytes_(std::exchange(rhs.mapped_bytes_, 0)),
+        capacity_(std::exchange(rhs.capacity_, 0)) {}
+
+    mapped_vector& operator=(mapped_vector&& rhs) noexcept {
+        mapped_vector(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    mapped_vector(const mapped_vector&) = delete;
+    mapped_vector& operator=(const mapped_vector&) = delete;
+
+    ~mapped_vector() { release(); }
+
+    void swap(mapped_vector& rhs) noexcept {
+        using std::swap;
+        swap(fd_, rhs.fd_);
+        swap(base_, rhs.base_);
+        swap(mapped_bytes_, rhs.mapped_bytes_);
+        swap(capacity_, rhs.capacity_);
+    }
+
+    friend void swap(mapped_vector& a, mapped_vector& b) noexcept { a.swap(b); }
+
+    iterator begin() noexcept { return data(); }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator cbegin() const noexcept { return data(); }
+    iterator end() noexcept { return data() + size(); }
+    const_iterator end() const noexcept { return cend(); }
+    const_iterator cend() const noexcept { return data() + size(); }
+
+    // A moved-from vector has neither a file nor a mapping. It's empty,
+    // with a null `data()`, until it's assigned to; `clear`, `resize(0)`
+    // and `sync` do nothing, and anything that would add elements throws
+    // `std::system_error`, since there is no file to grow.
+    //
+    T *data() noexcept {
+        return (base_ == nullptr) ? nullptr : std::launder(reinterpret_cast<T*>(base_ + data_offset));
+    }
+    const T *data() const noexcept {
+        return (base_ == nullptr) ? nullptr : std::launder(reinterpret_cast<const T*>(base_ + data_offset));
+    }
+
+    size_type size() const noexcept { return (base_ == nullptr) ? 0 : header().size; }
+    size_type capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size() == 0; }
+
+    T& operator[](size_type i) { return data()[i]; }
+    const T& operator[](size_type i) const { return data()[i]; }
+
+    T& at(size_type i) {
+        if (i >= size()) {
+            throw std::out_of_range("mapped_vector::at");
+        }
+        return data()[i];
+    }
+    const T& at(size_type i) const {
+        if (i >= size()) {
+            throw std::out_of_range("mapped_vector::at");
+        }
+        return data()[i];
+    }
+
+    T& front() { return data()[0]; }
+    const T& front() const { return data()[0]; }
+    T& back() { return data()[size() - 1]; }
+    const T& back() const { return data()[size() - 1]; }
+
+    void reserve(size_type n) {
+        if (n > capacity_) {
+            remap(n);
+        }
+    }
+
+    void shrink_to_fit() {
+        if (capacity_ > size()) {
+            remap(size());
+        }
+    }
+
+    void push_back(const T& value) {
+        if (size() == capacity_) {
+            // `value` may refer into the mapping, which is about to move.
+            T copy = value;
+            remap(grown_capacity(size() + 1));
+            data()[size()] = copy;
+        } else {
+            data()[size()] = value;
+        }
+        header().size += 1;
+    }
+
+    template<class... Args>
+    T& emplace_back(Args&&... args) {
+        push_back(T(std::forward<Args>(args)...));
+        return back();
+    }
+
+    void pop_back() noexcept { header().size -= 1; }
+
+    void resize(size_type n, const T& value = T()) {
+        if (n > capacity_) {
+            T copy = value;
+            remap(grown_capacity(n));
+            std::fill(data() + size(), data() + n, copy);
+        } else if (n > size()) {
+            std::fill(data() + size(), data() + n, value);
+        }
+        if (base_ != nullptr) {
+            header().size = n;
+        }
+    }
+
+    void clear() noexcept {
+        if (base_ != nullptr) {
+            header().size = 0;
+        }
+    }
+
+    // Writes every modified page back to the file, and blocks until that's done.
+    //
+    void sync() {
+        if (base_ != nullptr && ::msync(base_, mapped_bytes_, MS_SYNC) == -1) {
+            throw_errno("mapped_vector: msync");
+        }
+    }
+
+  private:
+    struct file_header {
+        std::uint64_t magic;
+        std::uint32_t version;
+        std::uint32_t value_size;
+        std::uint32_t value_align;
+        std::uint32_t reserved;
+        std::uint64_t size;
+    };
+
+    static constexpr std::uint64_t magic_number = 0x524f5443'45564d4dULL;  // "MMVECTOR" (little-endian)
+    static constexpr std::uint32_t current_version = 1;
+
+    // The elements start on a 64-byte boundary (or `alignof(T)`, if larger),
+    // so that they're as aligned in the file as they would be in memory.
+    static constexpr size_type data_alignment = std::max(alignof(T), size_type(64));
+    static constexpr size_type data_offset = (sizeof(file_header) + data_alignment - 1) / data_alignment * data_alignment;
+
+    [[noreturn]] static void throw_errno(const char *what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    static size_type mapped_bytes(size_type capacity) { return data_offset + capacity * sizeof(T); }
+
+    size_type grown_capacity(size_type n) const { return std::max(n, capacity_ * 2); }
+
+    file_header& header() noexcept { return *std::launder(reinterpret_cast<file_header*>(base_)); }
+    const file_header& header() const noexcept { return *std::launder(reinterpret_cast<const file_header*>(base_)); }
+
+    void map(size_type bytes) {
+        void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            throw_errno("mapped_vector: mmap");
+        }
+        base_ = static_cast<unsigned char*>(p);
+        mapped_bytes_ = bytes;
+    }
+
+    void create() {
+        size_type capacity = std::max(size_type(1), (4096 - data_offset) / sizeof(T));
+        if (::ftruncate(fd_, mapped_bytes(capacity)) == -1) {
+            throw_errno("mapped_vector: ftruncate");
+        }
+        map(mapped_bytes(capacity));
+        capacity_ = capacity;
+        file_header h = {magic_number, current_version, sizeof(T), alignof(T), 0, 0};
+        header() = h;
+    }
+
+    void open_existing(size_type file_bytes) {
+        if (file_bytes < data_offset) {
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "mapped_vector: file is too short");
+        }
+        map(file_bytes);
+        capacity_ = (file_bytes - data_offset) / sizeof(T);
+        const file_header& h = header();
+        if (h.magic != magic_number || h.version != current_version ||
+            h.value_size != sizeof(T) || h.value_align != alignof(T) || h.size > capacity_) {
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "mapped_vector: bad file header");
+        }
+    }
+
+    void remap(size_type capacity) {
+        if (base_ == nullptr) {
+            throw std::system_error(std::make_error_code(std::errc::bad_file_descriptor), "mapped_vector: moved-from vector");
+        }
+        size_type old_bytes = mapped_bytes_;
+        size_type new_bytes = mapped_bytes(capacity);
+        if (new_bytes > old_bytes && ::ftruncate(fd_, new_bytes) == -1) {
+            throw_errno("mapped_vector: ftruncate");
+        }
+#if defined(MREMAP_MAYMOVE)
+        void *p = ::mremap(base_, old_bytes, new_bytes, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED) {
+            throw_errno("mapped_vector: mremap");
+        }
+        base_ = static_cast<unsigned char*>(p);
+        mapped_bytes_ = new_bytes;
+#else
+        ::munmap(base_, old_bytes);
+        base_ = nullptr;
+        map(new_bytes);
+#endif
+        capacity_ = capacity;
+        if (new_bytes < old_bytes && ::ftruncate(fd_, new_bytes) == -1) {
+            throw_errno("mapped_vector: ftruncate");
+        }
+    }
+
+    void release() noexcept {
+        if (base_ != nullptr) {
+            ::munmap(base_, mapped_bytes_);
+            base_ = nullptr;
+        }
+        if (fd_ != -1) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd_ = -1;
+    unsigned char *base_ = nullptr;
+    // The length of the mapping, which for a file we didn't create may be
+    // more than `mapped_bytes(capacity_)`.
+    size_type mapped_bytes_ = 0;
+    size_type capacity_ = 0;
+};
@@ -0,0 +1,584 @@
+#pragma once
+
+#include <algorithm>  // binary_search, sort
+#include <atomic>  // atomic, atomic_thread_fence, memory_order
+#include <cassert>  // assert
+#include <cstddef>  // nullptr_t, size_t
+#include <cstdint>  // uint64_t
+#include <mutex>  // defer_lock_t
+#include <utility>  // exchange, move, pair, swap
+#include <vector>  // erase_if, vector
+
+// Safe memory reclamation for lock-free linked containers. A thread that
+// unlinks a node from such a container can't free it right away, because
+// other threads may still be reading it; instead it *retires* the node, and
+// the node is freed once no thread can be holding a pointer to it. There
+// are two ways to know when that is:
+//
+//   - `epoch_domain` (Fraser, "Practical lock-freedom", 2004) keeps a global
+//     epoch number. A reader enters a critical section by announcing the
+//     epoch it saw, with an `epoch_guard`, and may follow any pointers it
+//     likes until the guard is destroyed. Nodes retired in epoch `e` are
+//     freed once every thread in a critical section has announced `e + 1`,
+//     and the global epoch has therefore reached `e + 2`. Entering and
+//     leaving are cheap (a store and a fence), and guards are copyable, so
+//     an iterator can simply hold one while it walks a list. The catch is
+//     that one stalled reader holds up all reclamation, without bound.
+//
+//   - `hazard_domain` (Michael, "Hazard pointers: safe memory reclamation
+//     for lock-free objects", 2004) has each reader publish the address of
+//     each node it's about to read, with a `hazard_pointer`. A retired node
+//     is freed as soon as no hazard pointer holds its address, so at most
+//     a fixed number of nodes per thread are ever awaiting reclamation, even
+//     if a reader stalls. In exchange, a traversal must protect every node it
+//     visits, one `seq_cst` fence per step.
+//
+// Each domain keeps one record per thread that has used it, found through a
+// `thread_local` cache. A thread's record, with any nodes it retired but
+// couldn't yet free, goes back to the domain when the thread exits, to be
+// reused by the next thread. So a domain must outlive every thread that has
+// used it, except the thread that destroys it; normally one just uses
+// `default_domain()`. Destroying a domain frees every node still retired in
+// it.
+//
+
+// A retired node, and the function that frees it.
+//
+struct retired_node {
+    void *p;
+    void (*reclaim)(void*);
+};
+
+// Each thread's records, one per domain it has used. When the thread exits,
+// they're handed back to their domains.
+//
+template<class Domain>
+class thread_record_cache {
+    using Record = typename Domain::thread_record;
+
+  public:
+    thread_record_cache() noexcept { alive() = true; }
+
+    ~thread_record_cache() {
+        alive() = false;
+        for (auto& [domain, record] : entries_) {
+            domain->release_record(record);
+        }
+    }
+
+    Record *find(const Domain *domain) const noexcept {
+        for (auto& [d, r] : entries_) {
+            if (d == domain) {
+                return r;
+            }
+        }
+        return nullptr;
+    }
+
+    void insert(Domain *domain, Record *record) { entries_.emplace_back(domain, record); }
+
+    static thread_record_cache& local() {
+        thread_local thread_record_cache cache;
+        return cache;
+    }
+
+    // Called by a domain's destructor. The `default_domain()`s are destroyed
+    // after the main thread's cache, which must not be brought back to life.
+    //
+    static void forget(const Domain *domain) noexcept {
+        if (alive()) {
+            std::erase_if(local().entries_, [&](auto& e) { return e.first == domain; });
+        }
+    }
+
+  private:
+    // A `bool` has no destructor, so this can be read even after the
+    // cache's destructor has run.
+    static bool& alive() noexcept {
+        thread_local bool alive = false;
+        return alive;
+    }
+
+    std::vector<std::pair<Domain*, Record*>> entries_;
+};
+
+class epoch_guard;
+
+class epoch_domain {
+  public:
+    epoch_domain() = default;
+    epoch_domain(const epoch_domain&) = delete;
+    epoch_domain& operator=(const epoch_domain&) = delete;
+
+    ~epoch_domain() {
+        thread_record_cache<epoch_domain>::forget(this);
+        thread_record *r = records_.load(std::memory_order_acquire);
+        while (r != nullptr) {
+            assert(r->nesting == 0);
+            for (bucket& b : r->limbo) {
+                free_bucket(b);
+            }
+            delete std::exchange(r, r->next);
+        }
+    }
+
+    static epoch_domain& default_domain() {
+        static epoch_domain domain;
+        return domain;
+    }
+
+    // Frees `p`, with `delete`, once no critical section that began before
+    // this call remains. `p` must already be unreachable for any thread that
+    // enters a critical section after this call.
+    //
+    template<class T>
+    void retire(T *p) {
+        retire(p, [](void *q) { delete static_cast<T*>(q); });
+    }
+
+    // The fence orders the caller's unlink before the epoch is read. Without
+    // it, on a weakly ordered machine, the node could be tagged with an epoch
+    // older than one that a reader announced before it saw the node, and be
+    // freed an epoch too early. (crossbeam-epoch's `push_bag` does the same.)
+    //
+    void retire(void *p, void (*reclaim)(void*)) {
+        thread_record *r = local_record();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t e = epoch_.load(std::memory_order_acquire);
+        bucket& b = r->limbo[e % 3];
+        if (b.epoch != e) {
+            // The bucket holds nodes from epoch `e - 3` or earlier, which
+            // are safe to free now.
+            free_bucket(b);
+            b.epoch = e;
+        }
+        b.items.push_back({p, reclaim});
+        if (++r->retired_since_collect >= collect_threshold) {
+            r->retired_since_collect = 0;
+            try_advance();
+            collect(r);
+        }
+    }
+
+    // Tries to advance the epoch, and frees whatever this thread, or any
+    // thread that has since exited, retired that is now safe to free.
+    // Calling this twice, with no critical sections open anywhere, frees
+    // everything.
+    //
+    void try_reclaim() {
+        try_advance();
+        collect(local_record());
+        for (thread_record *r = records_.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            if (!r->in_use.load(std::memory_order_relaxed) && !r->in_use.exchange(true, std::memory_order_acquire)) {
+                collect(r);
+                release_record(r);
+            }
+        }
+    }
+
+    std::uint64_t epoch() const noexcept { return epoch_.load(std::memory_order_acquire); }
+
+  private:
+    friend class epoch_guard;
+    friend class thread_record_cache<epoch_domain>;
+
+    // How many nodes a thread retires between attempts to advance the epoch.
+    static constexpr unsigned collect_threshold = 64;
+    static constexpr std::size_t cache_line = 64;
+
+    struct bucket {
+        std::uint64_t epoch = 0;
+        std::vector<retired_node> items;
+    };
+
+    // `announced` is zero outside a critical section, and `2 * epoch + 1`
+    // inside one. Only its own thread writes it.
+    //
+    struct alignas(cache_line) thread_record {
+        std::atomic<std::uint64_t> announced = 0;
+        std::atomic<bool> in_use = true;
+        thread_record *next = nullptr;
+        unsigned nesting = 0;
+        unsigned retired_since_collect = 0;
+        bucket limbo[3];
+    };
+
+    static void free_bucket(bucket& b) {
+        for (const retired_node& n : b.items) {
+            n.reclaim(n.p);
+        }
+        b.items.clear();
+    }
+
+    thread_record *local_record() {
+        auto& cache = thread_record_cache<epoch_domain>::local();
+        thread_record *r = cache.find(this);
+        if (r == nullptr) {
+            r = acquire_record();
+            cache.insert(this, r);
+        }
+        return r;
+    }
+
+    // Records are never unlinked, so this walk is safe without any
+    // reclamation scheme of its own.
+    //
+    thread_record *acquire_record() {
+        for (thread_record *r = records_.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            if (!r->in_use.load(std::memory_order_relaxed) && !r->in_use.exchange(true, std::memory_order_acquire)) {
+                return r;
+            }
+        }
+        thread_record *r = new thread_record;
+        r->next = records_.load(std::memory_order_relaxed);
+        while (!records_.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return r;
+    }
+
+    void release_record(thread_record *r) noexcept {
+        assert(r->nesting == 0);
+        r->in_use.store(false, std::memory_order_release);
+    }
+
+    // The fence after the announcement pairs with the fence in
+    // `try_advance`: either the advancing thread sees this thread's
+    // announcement, or this thread sees every pointer unlinked before the
+    // epoch advanced. A thread already in a critical section announces `e`
+    // anyway if it's older than what it announced before, which happens
+    // only when a guard from another thread is copied.
+    //
+    static void enter(thread_record *r, std::uint64_t e) noexcept {
+        std::uint64_t a = 2 * e + 1;
+        if (r->nesting++ == 0 || a < r->announced.load(std::memory_order_relaxed)) {
+            r->announced.store(a, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    static void exit(thread_record *r) noexcept {
+        if (--r->nesting == 0) {
+            r->announced.store(0, std::memory_order_release);
+        }
+    }
+
+    bool try_advance() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t e = epoch_.load(std::memory_order_relaxed);
+        for (thread_record *r = records_.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            std::uint64_t a = r->announced.load(std::memory_order_acquire);
+            if (a != 0 && a != 2 * e + 1) {
+                return false;
+            }
+        }
+        return epoch_.compare_exchange_strong(e, e + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+
+    void collect(thread_record *r) {
+        std::uint64_t e = epoch_.load(std::memory_order_acquire);
+        for (bucket& b : r->limbo) {
+            if (b.epoch + 2 <= e) {
+                free_bucket(b);
+            }
+        }
+    }
+
+    alignas(cache_line) std::atomic<std::uint64_t> epoch_ = 2;
+    alignas(cache_line) std::atomic<thread_record*> records_ = nullptr;
+};
+
+// An `epoch_guard` is a critical section of its domain: while it exists,
+// nothing retired in the domain after it was created will be freed. Guards
+// nest, and copying one enters the critical section again, so an iterator
+// can hold one as a data member and remain an ordinary copyable iterator.
+//
+// A guard belongs to the thread that created it, and must be destroyed
+// there. Copying it, or moving it, on another thread (as when a range of
+// such iterators is split among a pool's workers) creates a guard of that
+// thread, which announces the same epoch as the original, so that whatever
+// the original protects stays protected for as long as the copy exists.
+//
+// `epoch_guard(std::defer_lock)` and a moved-from guard are empty, and
+// protect nothing.
+//
+class epoch_guard {
+  public:
+    epoch_guard() : epoch_guard(epoch_domain::default_domain()) {}
+
+    explicit epoch_guard(epoch_domain& domain) : domain_(&domain), record_(domain.local_record()) {
+        epoch_domain::enter(record_, domain.epoch_.load(std::memory_order_relaxed));
+    }
+
+    explicit epoch_guard(std::defer_lock_t) noexcept {}
+
+    // `rhs` keeps its epoch announced while this runs, so the epoch can't
+    // have advanced more than once since, and announcing it again is safe.
+    //
+    epoch_guard(epoch_guard const& rhs) : domain_(rhs.domain_) {
+        if (domain_ != nullptr) {
+            record_ = domain_->local_record();
+            epoch_domain::enter(record_, rhs.record_->announced.load(std::memory_order_acquire) / 2);
+        }
+    }
+
+    // On the same thread, a move just takes over `rhs`'s critical section.
+    //
+    epoch_guard(epoch_guard&& rhs) : domain_(rhs.domain_) {
+        if (domain_ != nullptr) {
+            record_ = domain_->local_record();
+            if (record_ == rhs.record_) {
+                rhs.domain_ = nullptr;
+                rhs.record_ = nullptr;
+            } else {
+                epoch_domain::enter(record_, rhs.record_->announced.load(std::memory_order_acquire) / 2);
+            }
+        }
+    }
+
+    epoch_guard& operator=(epoch_guard rhs) noexcept {
+        swap(*this, rhs);
+        return *this;
+    }
+
+    ~epoch_guard() {
+        if (record_ != nullptr) {
+            epoch_domain::exit(record_);
+        }
+    }
+
+    explicit operator bool() const noexcept { return record_ != nullptr; }
+
+    friend void swap(epoch_guard& a, epoch_guard& b) noexcept {
+        std::swap(a.domain_, b.domain_);
+        std::swap(a.record_, b.record_);
+    }
+
+  private:
+    epoch_domain *domain_ = nullptr;
+    epoch_domain::thread_record *record_ = nullptr;
+};
+
+class hazard_pointer;
+
+class hazard_domain {
+  public:
+    hazard_domain() = default;
+    hazard_domain(const hazard_domain&) = delete;
+    hazard_domain& operator=(const hazard_domain&) = delete;
+
+    ~hazard_domain() {
+        thread_record_cache<hazard_domain>::forget(this);
+        thread_record *t = threads_.load(std::memory_order_acquire);
+        while (t != nullptr) {
+            for (const retired_node& n : t->retired) {
+                n.reclaim(n.p);
+            }
+            delete std::exchange(t, t->next);
+        }
+        hazard_record *h = hazards_.load(std::memory_order_acquire);
+        while (h != nullptr) {
+            assert(!h->in_use.load(std::memory_order_relaxed));
+            delete std::exchange(h, h->next);
+        }
+    }
+
+    static hazard_domain& default_domain() {
+        static hazard_domain domain;
+        return domain;
+    }
+
+    // Frees `p`, with `delete`, once no hazard pointer protects it. `p` must
+    // already be unreachable for any thread that starts to protect it after
+    // this call.
+    //
+    template<class T>
+    void retire(T *p) {
+        retire(p, [](void *q) { delete static_cast<T*>(q); });
+    }
+
+    void retire(void *p, void (*reclaim)(void*)) {
+        thread_record *t = local_record();
+        t->retired.push_back({p, reclaim});
+        if (t->retired.size() >= 2 * hazard_count_.load(std::memory_order_relaxed) + scan_threshold) {
+            scan(t);
+        }
+    }
+
+    // Frees whatever this thread, or any thread that has since exited,
+    // retired that no hazard pointer protects.
+    //
+    void try_reclaim() {
+        scan(local_record());
+        for (thread_record *t = threads_.load(std::memory_order_acquire); t != nullptr; t = t->next) {
+            if (!t->in_use.load(std::memory_order_relaxed) && !t->in_use.exchange(true, std::memory_order_acquire)) {
+                scan(t);
+                release_record(t);
+            }
+        }
+    }
+
+  private:
+    friend class hazard_pointer;
+    friend class thread_record_cache<hazard_domain>;
+
+    static constexpr std::size_t scan_threshold = 64;
+    static constexpr std::size_t cache_line = 64;
+
+    struct alignas(cache_line) hazard_record {
+        std::atomic<const void*> ptr = nullptr;
+        std::atomic<bool> in_use = true;
+        hazard_record *next = nullptr;
+    };
+
+    struct thread_record {
+        std::atomic<bool> in_use = true;
+        thread_record *next = nullptr;
+        std::vector<retired_node> retired;
+    };
+
+    // Like the thread records, hazard records are never unlinked; a
+    // released one is reused by the next `hazard_pointer`.
+    //
+    hazard_record *acquire_hazard() {
+        for (hazard_record *h = hazards_.load(std::memory_order_acquire); h != nullptr; h = h->next) {
+            if (!h->in_use.load(std::memory_order_relaxed) && !h->in_use.exchange(true, std::memory_order_acquire)) {
+                return h;
+            }
+        }
+        hazard_record *h = new hazard_record;
+        h->next = hazards_.load(std::memory_order_relaxed);
+        while (!hazards_.compare_exchange_weak(h->next, h, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        hazard_count_.fetch_add(1, std::memory_order_relaxed);
+        return h;
+    }
+
+    static void release_hazard(hazard_record *h) noexcept {
+        h->ptr.store(nullptr, std::memory_order_release);
+        h->in_use.store(false, std::memory_order_release);
+    }
+
+    thread_record *local_record() {
+        auto& cache = thread_record_cache<hazard_domain>::local();
+        thread_record *t = cache.find(this);
+        if (t != nullptr) {
+            return t;
+        }
+        for (t = threads_.load(std::memory_order_acquire); t != nullptr; t = t->next) {
+            if (!t->in_use.load(std::memory_order_relaxed) && !t->in_use.exchange(true, std::memory_order_acquire)) {
+                break;
+            }
+        }
+        if (t == nullptr) {
+            t = new thread_record;
+            t->next = threads_.load(std::memory_order_relaxed);
+            while (!threads_.compare_exchange_weak(t->next, t, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+        }
+        cache.insert(this, t);
+        return t;
+    }
+
+    void release_record(thread_record *t) noexcept {
+        t->in_use.store(false, std::memory_order_release);
+    }
+
+    // The fence pairs with the one in `hazard_pointer::try_protect`: either
+    // this thread sees the hazard, or the protecting thread sees that the
+    // node was unlinked, and doesn't use it.
+    //
+    void scan(thread_record *t) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<const void*> hazards;
+        for (hazard_record *h = hazards_.load(std::memory_order_acquire); h != nullptr; h = h->next) {
+            if (const void *p = h->ptr.load(std::memory_order_acquire)) {
+                hazards.push_back(p);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+        std::vector<retired_node> keep;
+        for (const retired_node& n : t->retired) {
+            if (std::binary_search(hazards.begin(), hazards.end(), static_cast<const void*>(n.p))) {
+                keep.push_back(n);
+            } else {
+                n.reclaim(n.p);
+            }
+        }
+        t->retired = std::move(keep);
+    }
+
+    alignas(cache_line) std::atomic<hazard_record*> hazards_ = nullptr;
+    std::atomic<std::size_t> hazard_count_ = 0;
+    alignas(cache_line) std::atomic<thread_record*> threads_ = nullptr;
+};
+
+// A `hazard_pointer` protects at most one node at a time from being freed.
+// It's named after, and behaves like, the C++26 `std::hazard_pointer`:
+//
+//   hazard_pointer hp;
+//   Node *p = hp.protect(head);  // `head` is a `std::atomic<Node*>`
+//   ... // `*p` stays valid, even if another thread retires it meanwhile
+//   hp.reset_protection();
+//
+// To walk a linked list, use two and swap them at each step, so that the
+// current node stays protected while the next one is being protected.
+// A `hazard_pointer` is movable but not copyable.
+//
+class hazard_pointer {
+  public:
+    hazard_pointer() : hazard_pointer(hazard_domain::default_domain()) {}
+    explicit hazard_pointer(hazard_domain& domain) : record_(domain.acquire_hazard()) {}
+
+    hazard_pointer(hazard_pointer&& rhs) noexcept : record_(std::exchange(rhs.record_, nullptr)) {}
+
+    hazard_pointer& operator=(hazard_pointer&& rhs) noexcept {
+        hazard_pointer tmp(std::move(rhs));
+        swap(*this, tmp);
+        return *this;
+    }
+
+    ~hazard_pointer() {
+        if (record_ != nullptr) {
+            hazard_domain::release_hazard(record_);
+        }
+    }
+
+    bool empty() const noexcept { return record_ == nullptr; }
+
+    // If `src` still holds `p`, protects `p` and returns true. Otherwise,
+    // sets `p` to the new value of `src` and returns false.
+    //
+    template<class T>
+    bool try_protect(T*& p, const std::atomic<T*>& src) noexcept {
+        T *expected = p;
+        reset_protection(expected);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        p = src.load(std::memory_order_acquire);
+        if (p != expected) {
+            reset_protection();
+            return false;
+        }
+        return true;
+    }
+
+    // Returns the value of `src`, which is protected until the next call
+    // to any of these.
+    //
+    template<class T>
+    T *protect(const std::atomic<T*>& src) noexcept {
+        T *p = src.load(std::memory_order_relaxed);
+        while (!try_protect(p, src)) {
+        }
+        return p;
+    }
+
+    template<class T>
+    void reset_protection(const T *p) noexcept { record_->ptr.store(p, std::memory_order_release); }
+
+    void reset_protection(std::nullptr_t = nullptr) noexcept { record_->ptr.store(nullptr, std::memory_order_release); }
+
+    friend void swap(hazard_pointer& a, hazard_pointer& b) noexcept { std::swap(a.record_, b.record_); }
+
+  private:
+    hazard_domain::hazard_record *record_ = nullptr;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <compare>  // compare_three_way, strong_ordering
+#include <cstddef>  // nullptr_t, ptrdiff_t
+#include <cstdint>  // uintptr_t
+#include <iterator>  // random_access_iterator_tag, contiguous_iterator_tag
+#include <memory>  // addressof
+#include <type_traits>  // add_lvalue_reference_t, enable_if_t, is_convertible_v, is_void_v, remove_cv_t
+
+// `offset_ptr<T>` is a "fancy pointer" that stores the distance from its
+// own address to its target, rather than the target's absolute address.
+// A data structure linked together with `offset_ptr`s therefore stays valid
+// when the memory holding it is mapped at a different address, as happens
+// when two processes map the same shared memory segment.
+//
+// The distance is recomputed whenever an `offset_ptr` is copied or assigned,
+// so `offset_ptr` is not trivially copyable: it must not be `memcpy`d.
+// The null pointer is represented by the offset 1, which would point into
+// the middle of the `offset_ptr` itself, rather than by 0, which is the
+// distance from an object to itself.
+//
+// [pointer.traits], [allocator.requirements.general]: `offset_ptr<T>`
+// provides `element_type`, `rebind`, and `pointer_to`, and is a
+// contiguous iterator, so that it can serve as the `pointer` type of an
+// allocator (see `segment_allocator`) and of a container or iterator built
+// on one.
+//
+template<class T>
+class offset_ptr {
+  public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = offset_ptr;
+    using reference = std::add_lvalue_reference_t<T>;
+    using iterator_category = std::random_access_iterator_tag;
+    using iterator_concept = std::contiguous_iterator_tag;
+
+    template<class U>
+    using rebind = offset_ptr<U>;
+
+    offset_ptr() noexcept = default;
+    offset_ptr(std::nullptr_t) noexcept {}
+    offset_ptr(T *p) noexcept { set(p); }
+    offset_ptr(const offset_ptr& rhs) noexcept { set(rhs.get()); }
+
+    template<class U, std::enable_if_t<std::is_convertible_v<U*, T*>, int> = 0>
+    offset_ptr(const offset_ptr<U>& rhs) noexcept { set(rhs.get()); }
+
+    // [allocator.requirements.general]p5: A `void_pointer` must be
+    // convertible to any `pointer` via `static_cast`.
+    //
+    template<class U, std::enable_if_t<!std::is_convertible_v<U*, T*>, int> = 0>
+    explicit offset_ptr(const offset_ptr<U>& rhs) noexcept { set(static_cast<T*>(rhs.get())); }
+
+    offset_ptr& operator=(const offset_ptr& rhs) noexcept { set(rhs.get()); return *this; }
+    offset_ptr& operator=(T *p) noexcept { set(p); return *this; }
+    offset_ptr& operator=(std::nullptr_t) noexcept { off_ = null_offset; return *this; }
+
+    ~offset_ptr() = default;
+
+    T *get() const noexcept {
+        if (off_ == null_offset) {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(reinterpret_cast<std::uintptr_t>(this) + off_);
+    }
+
+    explicit operator bool() const noexcept { return off_ != null_offset; }
+
+    template<class U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+    U& operator*() const noexcept { return *get(); }
+
+    T *operator->() const noexcept { return get(); }
+
+    template<class U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+    U& operator[](difference_type n) const noexcept { return get()[n]; }
+
+    // [pointer.traits.functions]
+    template<class U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+    static offset_ptr pointer_to(U& r) noexcept { return offset_ptr(std::addressof(r)); }
+
+    offset_ptr& operator++() noexcept { return *this += 1; }
+    offset_ptr& operator--() noexcept { return *this -= 1; }
+    offset_ptr operator++(int) noexcept { offset_ptr tmp = *this; ++(*this); return tmp; }
+    offset_ptr operator--(int) noexcept { offset_ptr tmp = *this; --(*this); return tmp; }
+
+    // Moving the target by `n` elements changes the offset by the same amount
+    // regardless of where the `offset_ptr` itself lives.
+    //
+    offset_ptr& operator+=(difference_type n) noexcept { off_ += n * difference_type(sizeof(T)); return *this; }
+    offset_ptr& operator-=(difference_type n) noexcept { off_ -= n * difference_type(sizeof(T)); return *this; }
+
+    friend offset_ptr operator+(offset_ptr p, difference_type n) noexcept { return p += n; }
+    friend offset_ptr operator+(difference_type n, offset_ptr p) noexcept { return p += n; }
+    friend offset_ptr operator-(offset_ptr p, difference_type n) noexcept { return p -= n; }
+    friend difference_type operator-(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() - b.get(); }
+
+    friend void swap(offset_ptr& a, offset_ptr& b) noexcept {
+        T *tmp = a.get();
+        a = b.get();
+        b = tmp;
+    }
+
+    friend bool operator==(const offset_ptr& a, const offset_ptr& b) noexcept { return a.get() == b.get(); }
+    friend bool operator==(const offset_ptr& a, std::nullptr_t) noexcept { return !a; }
+    friend std::strong_ordering operator<=>(const offset_ptr& a, const offset_ptr& b) noexcept {
+        return std::compare_three_way()(a.get(), b.get());
+    }
+
+  private:
+    static constexpr std::uintptr_t null_offset = 1;
+
+    void set(T *p) noexcept {
+        off_ = (p == nullptr) ? null_offset : reinterpret_cast<std::uintptr_t>(p) - reinterpret_cast<std::uintptr_t>(this);
+    }
+
+    // Unsigned, so that the subtraction in `set` wraps instead of overflowing.
+    std::uintptr_t off_ = null_offset;
+};
+
+// [pointer.traits.optmem]: Providing `to_address` lets `std::to_address`
+// see through an `offset_ptr` without calling `operator->`.
+//
+template<class T>
+struct std::pointer_traits<offset_ptr<T>> {
+    using pointer = offset_ptr<T>;
+    using element_type = T;
+    using difference_type = std::ptrdiff_t;
+
+    template<class U>
+    using rebind = offset_ptr<U>;
+
+    template<class U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+    static pointer pointer_to(U& r) noexcept { return pointer::pointer_to(r); }
+
+    static T *to_address(const pointer& p) noexcept { return p.get(); }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>  // size_t
+#include <type_traits>  // basic_common_reference, integral_constant
+#include <utility>  // pair, tuple_element, tuple_size
+
+// `pair_reference<const Key&, T&>` is the proxy reference type of the map
+// iterators that have no `std::pair<Key, T>` in memory to refer to, such as
+// `FlatMapIterator` and `BtreeMapIterator`. It *is* a
+// `std::pair<const Key&, T&>`, with `first`, `second`, structured bindings,
+// `std::get`, and conversion to `std::pair<Key, T>`, and adds nothing of its
+// own.
+//
+// The reason it exists at all is [iterator.concept.readable]: for an
+// iterator to be `std::indirectly_readable`, its `reference` and
+// `value_type&` must have a common reference type. The C++23 library
+// provides one for `std::pair<const Key&, T&>` and `std::pair<Key, T>&`,
+// but the C++20 library doesn't, and we aren't allowed to specialize
+// `std::basic_common_reference` for types that are all from namespace
+// `std`. So we specialize it for `pair_reference` instead, as `bit_vector`
+// does for `bit_reference`: the common reference is the value type itself.
+//
+template<class First, class Second>
+struct pair_reference : std::pair<First, Second> {
+    using std::pair<First, Second>::pair;
+};
+
+template<class F1, class S1, class F2, class S2, template<class> class TQual, template<class> class UQual>
+struct std::basic_common_reference<pair_reference<F1, S1>, std::pair<F2, S2>, TQual, UQual> {
+    using type = std::pair<F2, S2>;
+};
+
+template<class F1, class S1, class F2, class S2, template<class> class TQual, template<class> class UQual>
+struct std::basic_common_reference<std::pair<F1, S1>, pair_reference<F2, S2>, TQual, UQual> {
+    using type = std::pair<F1, S1>;
+};
+
+// Like `std::pair`, it's tuple-like, so that e.g. `std::views::keys` accepts
+// a range of them.
+//
+template<class First, class Second>
+struct std::tuple_size<pair_reference<First, Second>> : std::integral_constant<std::size_t, 2> {};
+
+template<std::size_t I, class First, class Second>
+struct std::tuple_element<I, pair_reference<First, Second>> : std::tuple_element<I, std::pair<First, Second>> {};
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>  // max, min, ranges::lower_bound, ranges::merge, ranges::move, ranges::sort, ranges::upper_bound
+#include <array>  // array
+#include <bit>  // bit_cast
+#include <climits>  // CHAR_BIT
+#include <concepts>  // default_initializable, floating_point, integral, same_as, unsigned_integral
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint16_t, uint32_t, uint64_t, uint8_t
+#include <functional>  // ranges::less
+#include <iterator>  // iter_reference_t, iter_value_t, make_move_iterator, random_access_iterator, sortable
+#include <memory>  // make_unique_for_overwrite, unique_ptr
+#include <ranges>  // begin, end, random_access_range
+#include <type_traits>  // conditional_t, is_reference_v
+#include <utility>  // move
+#include <vector>  // vector
+
+#include "parallel.h"
+#include "work-stealing-pool.h"
+
+// `parallel_sort(first, last, comp)` is a parallel merge sort on
+// `work_stealing_pool::default_pool()`, for any sortable random-access
+// iterators whose value type is default-initializable. It sorts the two
+// halves of the range in parallel and then merges them in parallel,
+// ping-ponging between the range and a buffer of the same size so that each
+// level of the recursion moves every element once. Below a cutoff, it calls
+// `std::ranges::sort`; so, like `std::sort`, it isn't stable.
+//
+// `parallel_radix_sort(first, last)` is a parallel LSD radix sort of
+// integers or floating-point numbers, one byte per pass. Each pass splits
+// the range into blocks, counts the digits of each block in parallel, and
+// then scatters each block to its place in parallel. A pass in which every
+// key has the same digit is skipped, so small keys in wide types cost
+// fewer passes. Floating-point numbers sort in the order of `<`, except
+// that -0.0 sorts before +0.0 and NaNs sort to the ends according to their
+// sign bits.
+//
+// With a single worker, both simply sort sequentially. So do they for
+// iterators whose `reference` is a proxy (like `bit_vector`'s): two proxies
+// for distinct elements may read and write the same underlying word, so
+// writing through them from different threads would be a data race.
+//
+
+// Calls `f(i)` for each `i` in [first, last), in parallel.
+//
+template<class F>
+void parallel_for_index(work_stealing_pool& pool, std::size_t first, std::size_t last, F& f) {
+    if (last - first <= 1) {
+        if (first != last) {
+            f(first);
+        }
+        return;
+    }
+    std::size_t mid = first + (last - first) / 2;
+    pool.fork_join(
+        [&] { parallel_for_index(pool, first, mid, f); },
+        [&] { parallel_for_index(pool, mid, last, f); }
+    );
+}
+
+// Merges the sorted ranges [f1, l1) and [f2, l2) into `out`, by moving.
+// It splits the longer input at its midpoint and the other at the matching
+// bound, and merges the two halves in parallel. The merge is stable: on
+// ties, elements of the first range come first.
+//
+template<class It1, class It2, class Out, class Comp>
+void parallel_merge(work_stealing_pool& pool, It1 f1, It1 l1, It2 f2, It2 l2, Out out, Comp& comp) {
+    constexpr std::ptrdiff_t cutoff = 1 << 13;
+    std::ptrdiff_t n1 = l1 - f1;
+    std::ptrdiff_t n2 = l2 - f2;
+    if (n1 + n2 <= cutoff) {
+        std::ranges::merge(std::make_move_iterator(f1), std::make_move_iterator(l1),
+                           std::make_move_iterator(f2), std::make_move_iterator(l2), out, comp);
+        return;
+    }
+    It1 m1;
+    It2 m2;
+    if (n1 >= n2) {
+        m1 = f1 + n1 / 2;
+        m2 = std::ranges::lower_bound(f2, l2, *m1, comp);
+    } else {
+        m2 = f2 + n2 / 2;
+        m1 = std::ranges::upper_bound(f1, l1, *m2, comp);
+    }
+    Out mid_out = out + ((m1 - f1) + (m2 - f2));
+    pool.fork_join(
+        [&] { parallel_merge(pool, f1, m1, f2, m2, out, comp); },
+        [&] { parallel_merge(pool, m1, l1, m2, l2, mid_out, comp); }
+    );
+}
+
+// Sorts [first, last), leaving the result in `buf` if `into_buf` and in
+// [first, last) otherwise.
+//
+template<class It, class Buf, class Comp>
+void parallel_merge_sort(work_stealing_pool& pool, It first, It last, Buf buf, Comp& comp, bool into_buf) {
+    constexpr std::ptrdiff_t cutoff = 1 << 14;
+    std::ptrdiff_t n = last - first;
+    if (n <= cutoff) {
+        std::ranges::sort(first, last, comp);
+        if (into_buf) {
+            std::ranges::move(first, last, buf);
+        }
+        return;
+    }
+    It mid = first + n / 2;
+    Buf buf_mid = buf + n / 2;
+    pool.fork_join(
+        [&] { parallel_merge_sort(pool, first, mid, buf, comp, !into_buf); },
+        [&] { parallel_merge_sort(pool, mid, last, buf_mid, comp, !into_buf); }
+    );
+    if (into_buf) {
+        parallel_merge(pool, first, mid, mid, last, buf, comp);
+    } else {
+        parallel_merge(pool, buf, buf_mid, buf_mid, buf + n, first, comp);
+    }
+}
+
+template<std::random_access_iterator It, class Comp = std::ranges::less>
+    requires std::sortable<It, Comp>
+void parallel_sort(It first, It last, Comp comp = {}) {
+    using V = std::iter_value_t<It>;
+    work_stealing_pool& pool = work_stealing_pool::default_pool();
+    std::size_t n = last - first;
+    if constexpr (std::default_initializable<V> && std::is_reference_v<std::iter_reference_t<It>>) {
+        if (pool.concurrency() > 1 && n > (1 << 14)) {
+            auto buf = std::make_unique_for_overwrite<V[]>(n);
+            pool.run([&] { parallel_merge_sort(pool, first, last, buf.get(), comp, false); });
+            return;
+        }
+    }
+    std::ranges::sort(first, last, comp);
+}
+
+template<std::ranges::random_access_range R, class Comp = std::ranges::less>
+    requires std::sortable<std::ranges::iterator_t<R>, Comp>
+void parallel_sort(R&& r, Comp comp = {}) {
+    parallel_sort(std::ranges::begin(r), std::ranges::end(r), std::move(comp));
+}
+
+// The unsigned key whose order is the order of `T`: flip the sign bit of a
+// signed integer; flip the sign bit of a non-negative floating-point number
+// and every bit of a negative one.
+//
+template<class T>
+using radix_key_t = std::conditional_t<sizeof(T) == 1, std::uint8_t,
+                    std::conditional_t<sizeof(T) == 2, std::uint16_t,
+                    std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+
+template<class T>
+radix_key_t<T> radix_key(T x) noexcept {
+    using U = radix_key_t<T>;
+    constexpr U sign = U(U(1) << (sizeof(T) * CHAR_BIT - 1));
+    if constexpr (std::floating_point<T>) {
+        U bits = std::bit_cast<U>(x);
+        return (bits & sign) ? U(~bits) : U(bits | sign);
+    } else if constexpr (std::unsigned_integral<T>) {
+        return U(x);
+    } else {
+        return U(U(x) ^ sign);
+    }
+}
+
+template<std::random_access_iterator It>
+    requires (std::integral<std::iter_value_t<It>> && !std::same_as<std::iter_value_t<It>, bool>) ||
+             (std::floating_point<std::iter_value_t<It>> &&
+              (sizeof(std::iter_value_t<It>) == 4 || sizeof(std::iter_value_t<It>) == 8))
+void parallel_radix_sort(It first, It last) {
+    using V = std::iter_value_t<It>;
+    using Counts = std::array<std::size_t, 256>;
+    work_stealing_pool& pool = work_stealing_pool::default_pool();
+    std::size_t n = last - first;
+    if (n < 256 || !std::is_reference_v<std::iter_reference_t<It>>) {
+        std::ranges::sort(first, last);
+        return;
+    }
+    std::size_t blocks = std::min<std::size_t>(parallel_pieces(), std::max<std::size_t>(1, n / 4096));
+    std::size_t block_size = (n + blocks - 1) / blocks;
+    blocks = (n + block_size - 1) / block_size;
+    auto buf = std::make_unique_for_overwrite<V[]>(n);
+    std::vector<Counts> counts(blocks);
+
+    // Returns whether the pass did anything.
+    auto pass = [&](auto src, auto dst, unsigned shift) {
+        auto count = [&](std::size_t b) {
+            Counts& c = counts[b];
+            c.fill(0);
+            for (std::size_t i = b * block_size, e = std::min(n, i + block_size); i < e; ++i) {
+                c[(radix_key(V(src[i])) >> shift) & 0xff] += 1;
+            }
+        };
+        parallel_for_index(pool, 0, blocks, count);
+
+        std::size_t offset = 0;
+        for (std::size_t d = 0; d < 256; ++d) {
+            std::size_t total = 0;
+            for (std::size_t b = 0; b < blocks; ++b) {
+                total += counts[b][d];
+            }
+            if (total == n) {
+                return false;
+            }
+            for (std::size_t b = 0; b < blocks; ++b) {
+                std::size_t c = counts[b][d];
+                counts[b][d] = offset;
+                offset += c;
+            }
+        }
+
+        auto scatter = [&](std::size_t b) {
+            Counts& next = counts[b];
+            for (std::size_t i = b * block_size, e = std::min(n, i + block_size); i < e; ++i) {
+                V x = src[i];
+                dst[next[(radix_key(x) >> shift) & 0xff]++] = x;
+            }
+        };
+        parallel_for_index(pool, 0, blocks, scatter);
+        return true;
+    };
+
+    pool.run([&] {
+        bool in_buf = false;
+        for (unsigned shift = 0; shift < sizeof(V) * CHAR_BIT; shift += 8) {
+            if (in_buf ? pass(buf.get(), first, shift) : pass(first, buf.get(), shift)) {
+                in_buf = !in_buf;
+            }
+        }
+        if (in_buf) {
+            auto copy_back = [&](std::size_t b) {
+                for (std::size_t i = b * block_size, e = std::min(n, i + block_size); i < e; ++i) {
+                    first[i] = buf[i];
+                }
+            };
+            parallel_for_index(pool, 0, blocks, copy_back);
+        }
+    });
+}
+
+template<std::ranges::random_access_range R>
+void parallel_radix_sort(R&& r) {
+    parallel_radix_sort(std::ranges::begin(r), std::ranges::end(r));
+}
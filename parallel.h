@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cassert>  // assert
+#include <concepts>  // convertible_to, move_constructible, same_as
+#include <cstddef>  // size_t
+#include <iterator>  // forward_iterator, iter_difference_t, iter_reference_t, random_access_iterator
+#include <optional>  // optional
+#include <ranges>  // advance, begin, distance, end, forward_range, size, sized_range
+#include <type_traits>  // is_reference_v, is_void_v, remove_cvref_t
+#include <utility>  // move
+
+#include "work-stealing-pool.h"
+
+// The parallel algorithms here (`parallel_for_each`, `parallel_reduce` and
+// `parallel_transform`) work on *splittable ranges*, in the manner of TBB:
+// a range `r` is splittable if
+//
+//   - `r.empty()` says whether it has no elements,
+//   - `r.is_divisible()` says whether it's worth splitting any further, and
+//   - `split(r, p)`, found by argument-dependent lookup, moves a suffix of
+//     `r` into a new range of the same type and returns it. The prefix left
+//     in `r` should hold about `p.left / (p.left + p.right)` of the elements.
+//
+// Splitting proportionally, rather than always in half, lets an algorithm
+// running on three threads give one of them a third of the range and the
+// other two the remaining two thirds, which they split again.
+//
+// Any forward range of the containers in this repository can be made into
+// a splittable `blocked_range`, and the algorithms do so automatically when
+// they're handed a container. Finding the split point means advancing an
+// iterator about halfway through the range. That's O(1) for random-access
+// iterators; the other iterators can make it cheaper than O(n) by providing
+// an overload of `split_advance` (again found by argument-dependent lookup)
+// that takes whole leaves, words or blocks at a time.
+//
+// `std::execution::par` requires forward iterators too, but with no way
+// to split a range of them other than by walking it.
+//
+// The pieces run as tasks on a `work_stealing_pool`.
+//
+
+struct proportional_split {
+    std::size_t left = 1;
+    std::size_t right = 1;
+};
+
+// Advances `it` by exactly `n` elements, where `n` must not exceed the
+// distance to the end of its range. Iterators that can skip ahead faster
+// than one element at a time should overload this as a hidden friend.
+//
+template<std::forward_iterator It>
+void split_advance(It& it, std::iter_difference_t<It> n) {
+    std::ranges::advance(it, n);
+}
+
+template<class R>
+concept splittable_range = std::ranges::forward_range<R> && std::move_constructible<R> &&
+    requires(R& r, proportional_split p) {
+        { r.empty() } -> std::convertible_to<bool>;
+        { r.is_divisible() } -> std::convertible_to<bool>;
+        { split(r, p) } -> std::same_as<R>;
+    };
+
+// `blocked_range<It>` is an iterator pair that knows its own size, and is
+// divisible as long as that size exceeds its grain size. Splitting it costs
+// one call to `split_advance`.
+//
+template<std::forward_iterator It>
+class blocked_range {
+  public:
+    using iterator = It;
+    using size_type = std::size_t;
+    using difference_type = std::iter_difference_t<It>;
+
+    blocked_range() = default;
+
+    // O(n) unless `It` is a random-access iterator.
+    blocked_range(It first, It last, size_type grainsize = 1) :
+        blocked_range(first, last, size_type(std::ranges::distance(first, last)), grainsize) {}
+
+    // `size` must be the distance from `first` to `last`.
+    blocked_range(It first, It last, size_type size, size_type grainsize) :
+        first_(std::move(first)), last_(std::move(last)), size_(size), grainsize_(grainsize == 0 ? 1 : grainsize) {}
+
+    It begin() const { return first_; }
+    It end() const { return last_; }
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    size_type grainsize() const noexcept { return grainsize_; }
+    bool is_divisible() const noexcept { return size_ > grainsize_; }
+
+    friend blocked_range split(blocked_range& r, proportional_split p) {
+        assert(p.left != 0 && p.right != 0);
+        size_type parts = p.left + p.right;
+        size_type n = r.size_ / parts * p.left + r.size_ % parts * p.left / parts;
+        It mid = r.first_;
+        split_advance(mid, difference_type(n));
+        blocked_range right(mid, std::move(r.last_), r.size_ - n, r.grainsize_);
+        r.last_ = std::move(mid);
+        r.size_ = n;
+        return right;
+    }
+
+  private:
+    It first_ = It();
+    It last_ = It();
+    size_type size_ = 0;
+    size_type grainsize_ = 1;
+};
+
+// A `blocked_range` over all of `r`. This takes `r`'s size in O(1) if it is
+// a sized range, and walks it otherwise.
+//
+template<std::ranges::forward_range R>
+auto make_blocked_range(R& r, std::size_t grainsize = 1) {
+    using It = decltype(std::ranges::begin(r));
+    std::size_t n;
+    if constexpr (std::ranges::sized_range<R&>) {
+        n = std::size_t(std::ranges::size(r));
+    } else {
+        n = std::size_t(std::ranges::distance(r));
+    }
+    return blocked_range<It>(std::ranges::begin(r), std::ranges::end(r), n, grainsize);
+}
+
+template<class R>
+auto as_splittable_range(R& r) {
+    if constexpr (splittable_range<std::remove_cvref_t<R>>) {
+        return std::remove_cvref_t<R>(r);
+    } else {
+        return make_blocked_range(r);
+    }
+}
+
+// The algorithms run on `work_stealing_pool::default_pool()`. They split
+// their range into a few more pieces than there are workers, so that the
+// pool can even out pieces that take unequal time, by stealing.
+//
+inline unsigned parallel_concurrency() noexcept {
+    return work_stealing_pool::default_pool().concurrency();
+}
+
+inline unsigned parallel_pieces() noexcept {
+    unsigned n = parallel_concurrency();
+    return (n == 1) ? 1 : 4 * n;
+}
+
+// Splits `r` proportionally into `pieces` pieces, and calls
+// `body(piece, offset)` on each one, in parallel on `pool`, where `offset`
+// is the number of elements preceding the piece (if `R` is sized). The
+// results of adjacent pieces are combined in order with `join`, so `join`
+// need only be associative. An exception thrown by any `body` is rethrown
+// to the caller, after all the pieces have finished.
+//
+template<splittable_range R, class Body, class Join>
+auto parallel_split_invoke(work_stealing_pool& pool, R r, Body& body, Join& join, unsigned pieces, std::size_t offset = 0)
+    -> decltype(body(r, offset))
+{
+    using V = decltype(body(r, offset));
+    if (pieces <= 1 || !r.is_divisible()) {
+        return body(r, offset);
+    }
+    unsigned left_pieces = pieces / 2;
+    unsigned right_pieces = pieces - left_pieces;
+    R right = split(r, proportional_split{left_pieces, right_pieces});
+    std::size_t right_offset = offset;
+    if constexpr (std::ranges::sized_range<R>) {
+        right_offset += std::size_t(std::ranges::size(r));
+    }
+
+    if constexpr (std::is_void_v<V>) {
+        pool.fork_join(
+            [&] { parallel_split_invoke(pool, std::move(r), body, join, left_pieces, offset); },
+            [&] { parallel_split_invoke(pool, std::move(right), body, join, right_pieces, right_offset); }
+        );
+    } else {
+        std::optional<V> left_result;
+        std::optional<V> right_result;
+        pool.fork_join(
+            [&] { left_result.emplace(parallel_split_invoke(pool, std::move(r), body, join, left_pieces, offset)); },
+            [&] { right_result.emplace(parallel_split_invoke(pool, std::move(right), body, join, right_pieces, right_offset)); }
+        );
+        return join(std::move(*left_result), std::move(*right_result));
+    }
+}
+
+// Calls `f(x)` for every element `x` of `r`, concurrently. All the threads
+// share the one `f`.
+//
+template<class R, class F>
+void parallel_for_each(R&& r, F f) {
+    auto body = [&](auto& piece, std::size_t) {
+        for (auto&& x : piece) {
+            f(x);
+        }
+    };
+    auto join = [] {};
+    parallel_split_invoke(work_stealing_pool::default_pool(), as_splittable_range(r), body, join, parallel_pieces());
+}
+
+// Like `std::reduce`: combines `init` and the elements of `r` with `op`,
+// which must be associative but needn't be commutative. As for
+// `std::reduce`, `op` must also accept two partial results of type `T`.
+//
+template<class R, class T, class BinaryOp>
+T parallel_reduce(R&& r, T init, BinaryOp op) {
+    auto body = [&](auto& piece, std::size_t) {
+        std::optional<T> acc;
+        for (auto&& x : piece) {
+            if (acc) {
+                *acc = op(std::move(*acc), x);
+            } else {
+                acc.emplace(x);
+            }
+        }
+        return acc;
+    };
+    auto join = [&](std::optional<T> a, std::optional<T> b) {
+        if (a && b) {
+            return std::optional<T>(op(std::move(*a), std::move(*b)));
+        }
+        return a ? a : b;
+    };
+    std::optional<T> result =
+        parallel_split_invoke(work_stealing_pool::default_pool(), as_splittable_range(r), body, join, parallel_pieces());
+    return result ? op(std::move(init), std::move(*result)) : init;
+}
+
+// Like `std::transform`: assigns `f(x)` for the `i`th element `x` of `r`
+// to `out[i]`, and returns the end of the output. Each thread writes
+// its own piece of the output, so `out` must be random-access. If `out`'s
+// `reference` is a proxy (like `bit_vector`'s), neighbouring elements may
+// share a word, so the transform runs on the calling thread.
+//
+template<class R, std::random_access_iterator OutIt, class F>
+OutIt parallel_transform(R&& r, OutIt out, F f) {
+    auto range = as_splittable_range(r);
+    static_assert(std::ranges::sized_range<decltype(range)>);
+    std::size_t n = std::ranges::size(range);
+    auto body = [&](auto& piece, std::size_t offset) {
+        OutIt o = out + std::iter_difference_t<OutIt>(offset);
+        for (auto&& x : piece) {
+            *o = f(x);
+            ++o;
+        }
+    };
+    auto join = [] {};
+    unsigned pieces = std::is_reference_v<std::iter_reference_t<OutIt>> ? parallel_pieces() : 1;
+    parallel_split_invoke(work_stealing_pool::default_pool(), std::move(range), body, join, pieces);
+    return out + n;
+}
@@ -0,0 +1,757 @@
+#pragma once
+
+#include <algorithm>  // min
+#include <bit>  // countr_zero
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint8_t
+#include <cstring>  // memcmp
+#include <iterator>  // forward_iterator, forward_iterator_tag
+#include <memory>  // addressof, unique_ptr
+#include <string>  // string
+#include <string_view>  // string_view
+#include <tuple>  // forward_as_tuple
+#include <type_traits>  // remove_cv_t
+#include <utility>  // forward, move, pair, piecewise_construct, swap
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+
+template<
+    class QualifiedType,
+    class UnqualifiedType = std::remove_cv_t<QualifiedType>
+> struct RadixTrieIterator;
+
+// `radix_trie` is a string-keyed map implemented as an adaptive radix tree
+// (Leis, Kemper, Neumann, "The Adaptive Radix Tree", ICDE 2013).
+//
+// Each inner node consumes one byte of the key to choose a child, and
+// comes in one of four sizes depending on how many children it has:
+// `node4` and `node16` keep sorted parallel arrays of bytes and children
+// (`node16` is searched with a single SSE2 comparison), `node48` has a
+// 256-entry byte index into 48 child slots, and `node256` is a plain array.
+// Chains of single-child nodes are collapsed into a `prefix` string stored
+// in the first node of the chain (path compression), so the tree depth
+// is bounded by the number of branching points, not by the key length.
+//
+// A key that is a proper prefix of another key is stored in the inner node
+// where it ends, as that node's `terminal` leaf. Since the terminal sorts
+// before all of its node's children, an in-order walk visits the keys in
+// exactly the order `std::map<std::string, T>` would.
+//
+// Every node knows its parent and its position in that parent, which lets
+// `RadixTrieIterator` be just a pointer to the current leaf.
+//
+// Nodes grow as children are added, but don't shrink as children are
+// removed; `erase` only collapses a node once it has a single entry left.
+//
+template<class T>
+class radix_trie {
+  public:
+    using key_type = std::string;
+    using mapped_type = T;
+    using value_type = std::pair<const std::string, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using iterator = RadixTrieIterator<value_type>;
+    using const_iterator = RadixTrieIterator<const value_type>;
+
+    radix_trie() = default;
+
+    radix_trie(const radix_trie& other) {
+        for (const auto& kv : other) {
+            try_emplace(kv.first, kv.second);
+        }
+    }
+
+    radix_trie(radix_trie&& other) noexcept { swap(other); }
+
+    radix_trie& operator=(radix_trie other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~radix_trie() { clear(); }
+
+    iterator begin() { return iterator(root_ ? first_leaf(root_) : nullptr); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(root_ ? first_leaf(root_) : nullptr); }
+    iterator end() { return iterator(nullptr); }
+    const_iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(nullptr); }
+
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+
+    T& operator[](std::string_view key) { return try_emplace(key).first->second; }
+
+    std::pair<iterator, bool> insert(const value_type& kv) { return try_emplace(kv.first, kv.second); }
+    std::pair<iterator, bool> insert(value_type&& kv) { return try_emplace(kv.first, std::move(kv.second)); }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(std::string_view key, Args&&... args) {
+        if (root_ == nullptr) {
+            root_ = make_leaf(key, std::forward<Args>(args)...).release();
+            size_ = 1;
+            return {iterator(static_cast<leaf*>(root_)), true};
+        }
+        node **ref = &root_;
+        std::size_t depth = 0;
+        while (true) {
+            node *n = *ref;
+            if (n->kind == node_kind::leaf) {
+                auto *old = static_cast<leaf*>(n);
+                std::string_view old_key = old->value.first;
+                if (old_key == key) {
+                    return {iterator(old), false};
+                }
+                std::size_t p = common_prefix(old_key.substr(depth), key.substr(depth));
+                auto nl = make_leaf(key, std::forward<Args>(args)...);
+                auto *nn = new node4;
+                nn->prefix = key.substr(depth, p);
+                take_place_of(nn, old, ref);
+                attach(nn, old, old_key, depth + p);
+                attach(nn, nl.get(), key, depth + p);
+                size_ += 1;
+                return {iterator(nl.release()), true};
+            }
+            auto *in = static_cast<inner*>(n);
+            std::size_t p = common_prefix(in->prefix, key.substr(depth));
+            if (p < in->prefix.size()) {
+                // The key diverges partway through `in`'s compressed prefix.
+                // Split the prefix at that point with a new `node4`.
+                auto nl = make_leaf(key, std::forward<Args>(args)...);
+                auto *nn = new node4;
+                nn->prefix = in->prefix.substr(0, p);
+                take_place_of(nn, in, ref);
+                std::uint8_t b = in->prefix[p];
+                in->prefix.erase(0, p + 1);
+                insert_child(nn, b, in);
+                attach(nn, nl.get(), key, depth + p);
+                size_ += 1;
+                return {iterator(nl.release()), true};
+            }
+            depth += p;
+            if (depth == key.size()) {
+                if (in->terminal != nullptr) {
+                    return {iterator(in->terminal), false};
+                }
+                attach(in, make_leaf(key, std::forward<Args>(args)...).release(), key, depth);
+                size_ += 1;
+                return {iterator(in->terminal), true};
+            }
+            std::uint8_t b = key[depth];
+            node **child = find_child(in, b);
+            if (child == nullptr) {
+                auto nl = make_leaf(key, std::forward<Args>(args)...);
+                add_child(ref, in, b, nl.get());
+                size_ += 1;
+                return {iterator(nl.release()), true};
+            }
+            ref = child;
+            depth += 1;
+        }
+    }
+
+    iterator find(std::string_view key) { return iterator(find_leaf(key)); }
+    const_iterator find(std::string_view key) const { return const_iterator(find_leaf(key)); }
+    bool contains(std::string_view key) const { return find_leaf(key) != nullptr; }
+
+    // Returns the range of elements whose keys begin with `prefix`,
+    // in sorted order. The two iterators are found by a single descent
+    // of `prefix.size()` bytes, regardless of how many keys match.
+    //
+    std::pair<iterator, iterator> prefix_range(std::string_view prefix) {
+        auto [first, last] = prefix_bounds(prefix);
+        return {iterator(first), iterator(last)};
+    }
+    std::pair<const_iterator, const_iterator> prefix_range(std::string_view prefix) const {
+        auto [first, last] = prefix_bounds(prefix);
+        return {const_iterator(first), const_iterator(last)};
+    }
+
+    // Returns the element whose key is the longest prefix of `key`
+    // (possibly `key` itself), or `end()` if there is none.
+    //
+    iterator longest_prefix_match(std::string_view key) { return iterator(longest_prefix_leaf(key)); }
+    const_iterator longest_prefix_match(std::string_view key) const { return const_iterator(longest_prefix_leaf(key)); }
+
+    size_type erase(std::string_view key) {
+        leaf *l = find_leaf(key);
+        if (l == nullptr) {
+            return 0;
+        }
+        erase_leaf(l);
+        return 1;
+    }
+
+    iterator erase(const_iterator pos) {
+        leaf *l = pos.leaf_;
+        leaf *next = next_after(l);
+        erase_leaf(l);
+        return iterator(next);
+    }
+
+    void clear() noexcept {
+        if (root_ != nullptr) {
+            destroy_subtree(root_);
+        }
+        root_ = nullptr;
+        size_ = 0;
+    }
+
+    void swap(radix_trie& other) noexcept {
+        std::swap(root_, other.root_);
+        std::swap(size_, other.size_);
+    }
+    friend void swap(radix_trie& a, radix_trie& b) noexcept { a.swap(b); }
+
+  private:
+    template<class, class> friend struct RadixTrieIterator;
+
+    enum class node_kind : std::uint8_t { leaf, node4, node16, node48, node256 };
+
+    struct inner;
+
+    struct node {
+        explicit node(node_kind k) : kind(k) {}
+        node_kind kind;
+        bool is_terminal = false;
+        std::uint8_t byte_in_parent = 0;
+        inner *parent = nullptr;
+    };
+
+    struct leaf : node {
+        template<class... Args>
+        explicit leaf(std::string_view key, Args&&... args)
+            : node(node_kind::leaf), value(std::piecewise_construct,
+                                           std::forward_as_tuple(key),
+                                           std::forward_as_tuple(std::forward<Args>(args)...)) {}
+        value_type value;
+    };
+
+    struct inner : node {
+        using node::node;
+        std::string prefix;
+        leaf *terminal = nullptr;
+        unsigned count = 0;
+    };
+
+    struct node4 : inner {
+        node4() : inner(node_kind::node4) {}
+        std::uint8_t keys[4];
+        node *children[4];
+    };
+
+    struct node16 : inner {
+        node16() : inner(node_kind::node16) {}
+        alignas(16) std::uint8_t keys[16];
+        node *children[16];
+    };
+
+    struct node48 : inner {
+        node48() : inner(node_kind::node48) {}
+        std::uint8_t index[256] = {};  // slot + 1, or 0 if absent
+        node *children[48] = {};
+    };
+
+    struct node256 : inner {
+        node256() : inner(node_kind::node256) {}
+        node *children[256] = {};
+    };
+
+    template<class... Args>
+    static std::unique_ptr<leaf> make_leaf(std::string_view key, Args&&... args) {
+        return std::make_unique<leaf>(key, std::forward<Args>(args)...);
+    }
+
+    static std::size_t common_prefix(std::string_view a, std::string_view b) {
+        std::size_t n = std::min(a.size(), b.size());
+        std::size_t i = 0;
+        while (i < n && a[i] == b[i]) {
+            ++i;
+        }
+        return i;
+    }
+
+    // Returns a pointer to the slot holding the child for byte `b`,
+    // or null if there is no such child.
+    //
+    static node **find_child(inner *in, std::uint8_t b) {
+        switch (in->kind) {
+            case node_kind::node4: {
+                auto *n = static_cast<node4*>(in);
+                for (unsigned i = 0; i < n->count; ++i) {
+                    if (n->keys[i] == b) {
+                        return &n->children[i];
+                    }
+                }
+                return nullptr;
+            }
+            case node_kind::node16: {
+                auto *n = static_cast<node16*>(in);
+#if defined(__SSE2__)
+                __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(b)),
+                                             _mm_load_si128(reinterpret_cast<const __m128i*>(n->keys)));
+                unsigned mask = _mm_movemask_epi8(cmp) & ((1u << n->count) - 1);
+                return mask ? &n->children[std::countr_zero(mask)] : nullptr;
+#else
+                for (unsigned i = 0; i < n->count; ++i) {
+                    if (n->keys[i] == b) {
+                        return &n->children[i];
+                    }
+                }
+                return nullptr;
+#endif
+            }
+            case node_kind::node48: {
+                auto *n = static_cast<node48*>(in);
+                return n->index[b] ? &n->children[n->index[b] - 1] : nullptr;
+            }
+            case node_kind::node256: {
+                auto *n = static_cast<node256*>(in);
+                return n->children[b] ? &n->children[b] : nullptr;
+            }
+            default:
+                return nullptr;
+        }
+    }
+
+    // Returns the child with the smallest byte greater than `after`,
+    // or null if there is none. Pass `after = -1` to get the first child.
+    //
+    static node *next_child(const inner *in, int after) {
+        switch (in->kind) {
+            case node_kind::node4:
+            case node_kind::node16: {
+                const std::uint8_t *keys;
+                node *const *children;
+                if (in->kind == node_kind::node4) {
+                    keys = static_cast<const node4*>(in)->keys;
+                    children = static_cast<const node4*>(in)->children;
+                } else {
+                    keys = static_cast<const node16*>(in)->keys;
+                    children = static_cast<const node16*>(in)->children;
+                }
+                for (unsigned i = 0; i < in->count; ++i) {
+                    if (keys[i] > after) {
+                        return children[i];
+                    }
+                }
+                return nullptr;
+            }
+            case node_kind::node48: {
+                auto *n = static_cast<const node48*>(in);
+                for (int b = after + 1; b < 256; ++b) {
+                    if (n->index[b]) {
+                        return n->children[n->index[b] - 1];
+                    }
+                }
+                return nullptr;
+            }
+            case node_kind::node256: {
+                auto *n = static_cast<const node256*>(in);
+                for (int b = after + 1; b < 256; ++b) {
+                    if (n->children[b]) {
+                        return n->children[b];
+                    }
+                }
+                return nullptr;
+            }
+            default:
+                return nullptr;
+        }
+    }
+
+    // Inserts `child` into `in`, which must not be full.
+    //
+    static void insert_child(inner *in, std::uint8_t b, node *child) {
+        switch (in->kind) {
+            case node_kind::node4:
+            case node_kind::node16: {
+                std::uint8_t *keys;
+                node **children;
+                if (in->kind == node_kind::node4) {
+                    keys = static_cast<node4*>(in)->keys;
+                    children = static_cast<node4*>(in)->children;
+                } else {
+                    keys = static_cast<node16*>(in)->keys;
+                    children = static_cast<node16*>(in)->children;
+                }
+                unsigned i = in->count;
+                while (i > 0 && keys[i - 1] > b) {
+                    keys[i] = keys[i - 1];
+                    children[i] = children[i - 1];
+                    --i;
+                }
+                keys[i] = b;
+                children[i] = child;
+                break;
+            }
+            case node_kind::node48: {
+                auto *n = static_cast<node48*>(in);
+                unsigned slot = 0;
+                while (n->children[slot] != nullptr) {
+                    ++slot;
+                }
+                n->children[slot] = child;
+                n->index[b] = slot + 1;
+                break;
+            }
+            case node_kind::node256:
+                static_cast<node256*>(in)->children[b] = child;
+                break;
+            default:
+                break;
+        }
+        in->count += 1;
+        child->parent = in;
+        child->byte_in_parent = b;
+        child->is_terminal = false;
+    }
+
+    static void remove_child(inner *in, std::uint8_t b) {
+        switch (in->kind) {
+            case node_kind::node4:
+            case node_kind::node16: {
+                std::uint8_t *keys;
+                node **children;
+                if (in->kind == node_kind::node4) {
+                    keys = static_cast<node4*>(in)->keys;
+                    children = static_cast<node4*>(in)->children;
+                } else {
+                    keys = static_cast<node16*>(in)->keys;
+                    children = static_cast<node16*>(in)->children;
+                }
+                unsigned i = 0;
+                while (keys[i] != b) {
+                    ++i;
+                }
+                for (; i + 1 < in->count; ++i) {
+                    keys[i] = keys[i + 1];
+                    children[i] = children[i + 1];
+                }
+                break;
+            }
+            case node_kind::node48: {
+                auto *n = static_cast<node48*>(in);
+                n->children[n->index[b] - 1] = nullptr;
+                n->index[b] = 0;
+                break;
+            }
+            case node_kind::node256:
+                static_cast<node256*>(in)->children[b] = nullptr;
+                break;
+            default:
+                break;
+        }
+        in->count -= 1;
+    }
+
+    static unsigned capacity(const inner *in) {
+        switch (in->kind) {
+            case node_kind::node4: return 4;
+            case node_kind::node16: return 16;
+            case node_kind::node48: return 48;
+            default: return 256;
+        }
+    }
+
+    // Adds `child` to `in`, first replacing `in` (which lives in `*ref`)
+    // with the next larger node size if it is full.
+    //
+    static void add_child(node **ref, inner *in, std::uint8_t b, node *child) {
+        if (in->count == capacity(in)) {
+            inner *bigger;
+            switch (in->kind) {
+                case node_kind::node4: bigger = new node16; break;
+                case node_kind::node16: bigger = new node48; break;
+                default: bigger = new node256; break;
+            }
+            bigger->prefix = std::move(in->prefix);
+            bigger->terminal = in->terminal;
+            if (bigger->terminal != nullptr) {
+                bigger->terminal->parent = bigger;
+            }
+            for (node *c = next_child(in, -1); c != nullptr; c = next_child(in, c->byte_in_parent)) {
+                insert_child(bigger, c->byte_in_parent, c);
+            }
+            take_place_of(bigger, in, ref);
+            destroy_node(in);
+            in = bigger;
+        }
+        insert_child(in, b, child);
+    }
+
+    // Puts `replacement` into the slot `*ref` currently occupied by `n`.
+    //
+    static void take_place_of(node *replacement, node *n, node **ref) {
+        replacement->parent = n->parent;
+        replacement->byte_in_parent = n->byte_in_parent;
+        replacement->is_terminal = n->is_terminal;
+        *ref = replacement;
+    }
+
+    // Hangs leaf `l` (whose key is `key`) off of `in`, whose path from the
+    // root spells `key.substr(0, depth)`.
+    //
+    static void attach(inner *in, leaf *l, std::string_view key, std::size_t depth) {
+        if (key.size() == depth) {
+            in->terminal = l;
+            l->parent = in;
+            l->is_terminal = true;
+        } else {
+            insert_child(in, key[depth], l);
+        }
+    }
+
+    node **slot_of(node *n) {
+        if (n->parent == nullptr) {
+            return &root_;
+        }
+        return find_child(n->parent, n->byte_in_parent);
+    }
+
+    static leaf *first_leaf(node *n) {
+        while (n->kind != node_kind::leaf) {
+            auto *in = static_cast<inner*>(n);
+            if (in->terminal != nullptr) {
+                return in->terminal;
+            }
+            n = next_child(in, -1);
+        }
+        return static_cast<leaf*>(n);
+    }
+
+    // Returns the first leaf that follows the entire subtree rooted at `n`,
+    // or null if there is none.
+    //
+    static leaf *next_after(node *n) {
+        while (n->parent != nullptr) {
+            inner *p = n->parent;
+            node *c = next_child(p, n->is_terminal ? -1 : int(n->byte_in_parent));
+            if (c != nullptr) {
+                return first_leaf(c);
+            }
+            n = p;
+        }
+        return nullptr;
+    }
+
+    leaf *find_leaf(std::string_view key) const {
+        node *n = root_;
+        std::size_t depth = 0;
+        while (n != nullptr) {
+            if (n->kind == node_kind::leaf) {
+                auto *l = static_cast<leaf*>(n);
+                return (l->value.first == key) ? l : nullptr;
+            }
+            auto *in = static_cast<inner*>(n);
+            std::size_t plen = in->prefix.size();
+            if (key.size() - depth < plen || std::memcmp(key.data() + depth, in->prefix.data(), plen) != 0) {
+                return nullptr;
+            }
+            depth += plen;
+            if (depth == key.size()) {
+                return in->terminal;
+            }
+            node **child = find_child(in, key[depth]);
+            n = child ? *child : nullptr;
+            depth += 1;
+        }
+        return nullptr;
+    }
+
+    std::pair<leaf*, leaf*> prefix_bounds(std::string_view prefix) const {
+        node *n = root_;
+        std::size_t depth = 0;
+        while (n != nullptr) {
+            if (n->kind == node_kind::leaf) {
+                auto *l = static_cast<leaf*>(n);
+                if (std::string_view(l->value.first).substr(0, prefix.size()) == prefix) {
+                    return {l, next_after(l)};
+                }
+                break;
+            }
+            auto *in = static_cast<inner*>(n);
+            std::string_view rest = prefix.substr(depth);
+            if (rest.size() <= in->prefix.size()) {
+                if (std::string_view(in->prefix).substr(0, rest.size()) == rest) {
+                    return {first_leaf(in), next_after(in)};
+                }
+                break;
+            }
+            if (rest.substr(0, in->prefix.size()) != in->prefix) {
+                break;
+            }
+            depth += in->prefix.size();
+            node **child = find_child(in, prefix[depth]);
+            n = child ? *child : nullptr;
+            depth += 1;
+        }
+        return {nullptr, nullptr};
+    }
+
+    leaf *longest_prefix_leaf(std::string_view key) const {
+        leaf *best = nullptr;
+        node *n = root_;
+        std::size_t depth = 0;
+        while (n != nullptr) {
+            if (n->kind == node_kind::leaf) {
+                auto *l = static_cast<leaf*>(n);
+                if (key.substr(0, l->value.first.size()) == l->value.first) {
+                    best = l;
+                }
+                break;
+            }
+            auto *in = static_cast<inner*>(n);
+            if (key.substr(depth, in->prefix.size()) != in->prefix) {
+                break;
+            }
+            depth += in->prefix.size();
+            if (in->terminal != nullptr) {
+                best = in->terminal;
+            }
+            if (depth == key.size()) {
+                break;
+            }
+            node **child = find_child(in, key[depth]);
+            n = child ? *child : nullptr;
+            depth += 1;
+        }
+        return best;
+    }
+
+    void erase_leaf(leaf *l) {
+        inner *p = l->parent;
+        if (p == nullptr) {
+            root_ = nullptr;
+        } else if (l->is_terminal) {
+            p->terminal = nullptr;
+        } else {
+            remove_child(p, l->byte_in_parent);
+        }
+        delete l;
+        size_ -= 1;
+        if (p != nullptr && p->count + (p->terminal != nullptr) == 1) {
+            collapse(p);
+        }
+    }
+
+    // `p` has only one entry left; replace `p` with that entry,
+    // folding `p`'s prefix into it if it's an inner node.
+    //
+    void collapse(inner *p) {
+        node **ref = slot_of(p);
+        node *only;
+        if (p->terminal != nullptr) {
+            only = p->terminal;
+        } else {
+            only = next_child(p, -1);
+            if (only->kind != node_kind::leaf) {
+                auto *c = static_cast<inner*>(only);
+                c->prefix.insert(c->prefix.begin(), static_cast<char>(only->byte_in_parent));
+                c->prefix.insert(0, p->prefix);
+            }
+        }
+        take_place_of(only, p, ref);
+        destroy_node(p);
+    }
+
+    static void destroy_node(node *n) {
+        switch (n->kind) {
+            case node_kind::leaf: delete static_cast<leaf*>(n); break;
+            case node_kind::node4: delete static_cast<node4*>(n); break;
+            case node_kind::node16: delete static_cast<node16*>(n); break;
+            case node_kind::node48: delete static_cast<node48*>(n); break;
+            case node_kind::node256: delete static_cast<node256*>(n); break;
+        }
+    }
+
+    static void destroy_subtree(node *n) {
+        if (n->kind != node_kind::leaf) {
+            auto *in = static_cast<inner*>(n);
+            if (in->terminal != nullptr) {
+                destroy_node(in->terminal);
+            }
+            for (node *c = next_child(in, -1); c != nullptr; ) {
+                int b = c->byte_in_parent;
+                destroy_subtree(c);
+                c = next_child(in, b);
+            }
+        }
+        destroy_node(n);
+    }
+
+    node *root_ = nullptr;
+    size_type size_ = 0;
+};
+
+// `RadixTrieIterator` is a pointer to the current leaf; a null pointer
+// represents `end()`, so a default-constructed iterator compares equal
+// to any `end()`. Incrementing climbs toward the root until it finds a
+// node with a later child, then descends to that child's first leaf.
+//
+template<class QualifiedType,
+         class UnqualifiedType /* = std::remove_cv_t<QualifiedType> */>
+struct RadixTrieIterator
+{
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = UnqualifiedType;
+    using difference_type = std::ptrdiff_t;
+    using pointer = QualifiedType*;
+    using reference = QualifiedType&;
+
+    RadixTrieIterator() {}
+
+    using trie = radix_trie<typename UnqualifiedType::second_type>;
+    friend trie;
+    template<class, class> friend struct RadixTrieIterator;
+  private:
+    explicit RadixTrieIterator(typename trie::leaf *leaf) : leaf_(leaf) {}
+  public:
+
+    RadixTrieIterator(RadixTrieIterator const&) = default;
+    RadixTrieIterator& operator=(RadixTrieIterator const&) = default;
+    RadixTrieIterator(RadixTrieIterator&&) noexcept = default;
+    RadixTrieIterator& operator=(RadixTrieIterator&&) = default;
+    ~RadixTrieIterator() = default;
+
+    RadixTrieIterator operator++(int) {
+        RadixTrieIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    RadixTrieIterator& operator++() {
+        leaf_ = trie::next_after(leaf_);
+        return *this;
+    }
+
+    reference operator*() const { return leaf_->value; }
+
+    pointer operator->() const { return std::addressof(*(*this)); }
+
+    friend void swap(RadixTrieIterator& a, RadixTrieIterator& b) {
+        std::swap(a.leaf_, b.leaf_);
+    }
+
+    template<class QT>
+    bool operator==(RadixTrieIterator<QT> const& other) const { return leaf_ == other.leaf_; }
+
+    template<class QT>
+    bool operator!=(RadixTrieIterator<QT> const& other) const { return !(*this == other); }
+
+    operator RadixTrieIterator<const UnqualifiedType>() const {
+        return RadixTrieIterator<const UnqualifiedType>(leaf_);
+    }
+
+  private:
+    typename trie::leaf *leaf_ = nullptr;
+};
+
+static_assert(std::forward_iterator<radix_trie<int>::iterator>);
+static_assert(std::forward_iterator<radix_trie<int>::const_iterator>);
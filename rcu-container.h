@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>  // atomic, memory_order
+#include <memory>  // make_unique, unique_ptr
+#include <mutex>  // lock_guard, mutex
+#include <utility>  // forward, move
+
+#include "memory-reclamation.h"
+
+// `rcu_container<C>` holds an immutable `C` (any of the containers here, or
+// a standard one) behind an atomic pointer, for data that is read all the
+// time and rarely written, such as configuration or routing tables. It
+// works like read-copy-update in the Linux kernel (McKenney and Slingwine,
+// "Read-copy update: using execution history to solve concurrency
+// problems", 1998):
+//
+//   - A reader calls `read()`, which enters an `epoch_guard` and loads the
+//     pointer, and gets back a `snapshot`: a `const C&` that stays valid,
+//     and unchanged, for as long as the snapshot exists. It iterates that
+//     with `C`'s ordinary `const_iterator`s. Neither step writes to any
+//     cache line shared with other readers, so readers on different cores
+//     never slow each other down, unlike with a `shared_mutex`, whose reader
+//     count is one cache line written by every reader.
+//
+//   - A writer calls `update(f)`, which copies the current `C`, applies
+//     `f` to the copy, publishes the copy with one atomic store, and retires
+//     the old `C` to the epoch domain, which frees it once every snapshot of
+//     it is gone. Writers are serialized by a mutex that readers never touch.
+//
+// Each update copies the whole container, so this suits data that changes
+// a few times a minute, not a few times a microsecond. After publishing,
+// a writer also tries to reclaim the copy it replaced, so that at most one
+// or two stale copies outlive their last snapshot.
+//
+template<class C>
+class rcu_container {
+  public:
+    using value_type = C;
+
+    // A `snapshot` is copyable, like the `epoch_guard` it holds, and (like
+    // that guard) may be copied to another thread, where the copy keeps the
+    // same `C` alive, but must be destroyed on the thread that made it.
+    //
+    class snapshot {
+      public:
+        using const_iterator = typename C::const_iterator;
+
+        const C& operator*() const noexcept { return *data_; }
+        const C *operator->() const noexcept { return data_; }
+        const C *get() const noexcept { return data_; }
+
+        const_iterator begin() const { return data_->begin(); }
+        const_iterator end() const { return data_->end(); }
+
+      private:
+        friend class rcu_container;
+
+        explicit snapshot(epoch_guard guard, const C *data) noexcept : guard_(std::move(guard)), data_(data) {}
+
+        epoch_guard guard_;
+        const C *data_;
+    };
+
+    rcu_container() : rcu_container(C()) {}
+    explicit rcu_container(C value) : rcu_container(epoch_domain::default_domain(), std::move(value)) {}
+    rcu_container(epoch_domain& domain, C value) :
+        domain_(&domain), current_(new C(std::move(value))) {}
+
+    rcu_container(const rcu_container&) = delete;
+    rcu_container& operator=(const rcu_container&) = delete;
+
+    // Not thread-safe.
+    ~rcu_container() { delete current_.load(std::memory_order_relaxed); }
+
+    // The guard is entered before the pointer is loaded, so the `C` loaded
+    // can't be freed until the snapshot is destroyed, however soon a writer
+    // replaces it.
+    //
+    snapshot read() const {
+        epoch_guard guard(*domain_);
+        const C *data = current_.load(std::memory_order_acquire);
+        return snapshot(std::move(guard), data);
+    }
+
+    // Copies the current value, calls `f(copy)`, and publishes the copy.
+    // Readers see either the old value or the new one, never a mixture.
+    // If `f` throws, nothing is published.
+    //
+    template<class F>
+    void update(F&& f) {
+        {
+            std::lock_guard<std::mutex> lk(writer_mutex_);
+            auto copy = std::make_unique<C>(*current_.load(std::memory_order_relaxed));
+            std::forward<F>(f)(*copy);
+            publish(std::move(copy));
+        }
+        reclaim();
+    }
+
+    // Publishes `value` in place of the current value.
+    //
+    void store(C value) {
+        auto replacement = std::make_unique<C>(std::move(value));
+        {
+            std::lock_guard<std::mutex> lk(writer_mutex_);
+            publish(std::move(replacement));
+        }
+        reclaim();
+    }
+
+  private:
+    // Called with `writer_mutex_` held.
+    void publish(std::unique_ptr<C> replacement) {
+        const C *old = current_.exchange(replacement.release(), std::memory_order_acq_rel);
+        domain_->retire(const_cast<C*>(old));
+    }
+
+    // The domain would otherwise advance its epoch only once every few
+    // dozen retires, and as many stale copies of `C` would pile up. Two
+    // attempts free the copy just retired if no snapshot of it remains;
+    // otherwise it's freed by the next update after its last snapshot goes.
+    // This runs outside `writer_mutex_`, since it may destroy large `C`s.
+    //
+    void reclaim() {
+        domain_->try_reclaim();
+        domain_->try_reclaim();
+    }
+
+    epoch_domain *domain_;
+    std::atomic<const C*> current_;
+    std::mutex writer_mutex_;
+};
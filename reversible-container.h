@@ -1,23 +1,152 @@
 #pragma once
 
-#include <iterator>  // reverse_iterator
+#include <iterator>  // contiguous_iterator, iter_difference_t, iter_reference_t, iter_value_t, random_access_iterator_tag, reverse_iterator
+#include <memory>  // to_address
+#include <type_traits>  // conditional_t, is_convertible_v
+#include <utility>  // declval, swap
+
+template<class Iterator> struct ContiguousReverseIterator;
+
+// `reversible_container<CRTP>` is instantiated as a base class of CRTP, at
+// which point CRTP is still an incomplete type. That means we can't name
+// `typename CRTP::iterator` anywhere in the class body itself (only inside
+// member function bodies, which are instantiated lazily). The derived class
+// should therefore spell its own member typedefs, like this:
+//
+//   using reverse_iterator = reverse_iterator_t<iterator>;
+//   using const_reverse_iterator = reverse_iterator_t<const_iterator>;
+//
+// A container whose iterators are contiguous, and already complete types at
+// that point (pointers, or the iterators of `std::vector`), should use
+// `contiguous_reverse_iterator_t` instead. Don't use it with an iterator type
+// that is still incomplete: checking `std::contiguous_iterator` on it would
+// fail, and that answer would stick.
+//
+template<class Iterator>
+using reverse_iterator_t = std::reverse_iterator<Iterator>;
+
+template<class Iterator>
+using contiguous_reverse_iterator_t = std::conditional_t<
+    std::contiguous_iterator<Iterator>,
+    ContiguousReverseIterator<Iterator>,
+    std::reverse_iterator<Iterator>
+>;
 
 template<class CRTP>
 struct reversible_container {
-    using reverse_iterator = std::reverse_iterator<typename CRTP::iterator>;
-    using const_reverse_iterator = std::reverse_iterator<typename CRTP::const_iterator>;
+    auto rbegin() { return typename CRTP::reverse_iterator(self().end()); }
+    auto rbegin() const { return crbegin(); }
+    auto crbegin() const { return typename CRTP::const_reverse_iterator(self().cend()); }
 
-    reverse_iterator rbegin() { return reverse_iterator(this->end()); }
-    reverse_iterator rbegin() const { return crbegin(); }
-    const_reverse_iterator crbegin() { return const_reverse_iterator(this->cend()); }
-
-    reverse_iterator rend() { return reverse_iterator(this->begin()); }
-    reverse_iterator rend() const { return crend(); }
-    const_reverse_iterator crend() { return const_reverse_iterator(this->cbegin()); }
+    auto rend() { return typename CRTP::reverse_iterator(self().begin()); }
+    auto rend() const { return crend(); }
+    auto crend() const { return typename CRTP::const_reverse_iterator(self().cbegin()); }
 
     // The SGI STL's "ReversibleContainer" concept includes the two member functions
     // typename reverse_iterator::reference back() { return *rbegin(); }
     // typename const_reverse_iterator::reference back() const { return *crbegin(); }
     // but as `class CRTP` itself may know a more efficient way to compute back(),
     // we don't presume to implement it here.
+
+  private:
+    CRTP& self() { return static_cast<CRTP&>(*this); }
+    const CRTP& self() const { return static_cast<const CRTP&>(*this); }
+};
+
+// [reverse.iterators]: `std::reverse_iterator` holds the iterator one past
+// the element it refers to, so its `operator*` must copy that iterator and
+// decrement the copy on every dereference. For a contiguous iterator we can
+// instead address the element directly, as `std::to_address(base())[-1]`,
+// with no copy and no decrement; incrementing decrements `base()`.
+//
+// We still hold the base iterator rather than a pointer to the current
+// element: for `rend()` that pointer would be one *before* the first
+// element, which can't even be computed without undefined behavior.
+//
+// A `ContiguousReverseIterator<It>` converts to and from a
+// `std::reverse_iterator<It>` with the same `base()`.
+//
+template<class Iterator>
+struct ContiguousReverseIterator
+{
+    static_assert(std::contiguous_iterator<Iterator>);
+
+    using iterator_type = Iterator;
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::iter_value_t<Iterator>;
+    using difference_type = std::iter_difference_t<Iterator>;
+    using pointer = decltype(std::to_address(std::declval<const Iterator&>()));
+    using reference = std::iter_reference_t<Iterator>;
+
+    ContiguousReverseIterator() {}
+    explicit ContiguousReverseIterator(Iterator base) : base_(base) {}
+
+    template<class It> requires std::is_convertible_v<const It&, Iterator>
+    ContiguousReverseIterator(ContiguousReverseIterator<It> const& rhs) : base_(rhs.base()) {}
+
+    template<class It> requires std::is_convertible_v<const It&, Iterator>
+    ContiguousReverseIterator(std::reverse_iterator<It> const& rhs) : base_(rhs.base()) {}
+
+    operator std::reverse_iterator<Iterator>() const { return std::reverse_iterator<Iterator>(base_); }
+
+    ContiguousReverseIterator(ContiguousReverseIterator const&) = default;
+    ContiguousReverseIterator& operator=(ContiguousReverseIterator const&) = default;
+    ContiguousReverseIterator(ContiguousReverseIterator&&) noexcept = default;
+    ContiguousReverseIterator& operator=(ContiguousReverseIterator&&) = default;
+    ~ContiguousReverseIterator() = default;
+
+    Iterator base() const { return base_; }
+
+    ContiguousReverseIterator operator++(int) {
+        ContiguousReverseIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    ContiguousReverseIterator operator--(int) {
+        ContiguousReverseIterator tmp = *this;
+        --(*this);
+        return tmp;
+    }
+
+    ContiguousReverseIterator& operator++() { --base_; return *this; }
+    ContiguousReverseIterator& operator--() { ++base_; return *this; }
+
+    ContiguousReverseIterator& operator+=(difference_type n) { base_ -= n; return *this; }
+    ContiguousReverseIterator& operator-=(difference_type n) { base_ += n; return *this; }
+    ContiguousReverseIterator operator+(difference_type n) const { return ContiguousReverseIterator(base_ - n); }
+    ContiguousReverseIterator operator-(difference_type n) const { return ContiguousReverseIterator(base_ + n); }
+    friend ContiguousReverseIterator operator+(difference_type n, const ContiguousReverseIterator& it) { return it + n; }
+
+    template<class It>
+    difference_type operator-(ContiguousReverseIterator<It> const& other) const { return other.base() - base_; }
+
+    reference operator*() const { return std::to_address(base_)[-1]; }
+    reference operator[](difference_type n) const { return std::to_address(base_)[-1 - n]; }
+    pointer operator->() const { return std::to_address(base_) - 1; }
+
+    friend void swap(ContiguousReverseIterator& a, ContiguousReverseIterator& b) {
+        using std::swap;
+        swap(a.base_, b.base_);
+    }
+
+    template<class It>
+    bool operator==(ContiguousReverseIterator<It> const& other) const { return base_ == other.base(); }
+    template<class It>
+    bool operator!=(ContiguousReverseIterator<It> const& other) const { return !(*this == other); }
+    template<class It>
+    bool operator<(ContiguousReverseIterator<It> const& other) const { return other.base() < base_; }
+    template<class It>
+    bool operator>(ContiguousReverseIterator<It> const& other) const { return other < *this; }
+    template<class It>
+    bool operator<=(ContiguousReverseIterator<It> const& other) const { return !(other < *this); }
+    template<class It>
+    bool operator>=(ContiguousReverseIterator<It> const& other) const { return !(*this < other); }
+
+  private:
+    Iterator base_{};
 };
+
+static_assert(std::random_access_iterator<ContiguousReverseIterator<int*>>);
+static_assert(std::random_access_iterator<ContiguousReverseIterator<const int*>>);
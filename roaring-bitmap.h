@@ -0,0 +1,797 @@
+#pragma once
+
+#include <algorithm>  // binary_search, equal, lower_bound, max, min, set_union, upper_bound
+#include <bit>  // countr_zero, popcount
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // int16_t, uint16_t, uint32_t, uint64_t
+#include <initializer_list>  // initializer_list
+#include <iterator>  // back_inserter, forward_iterator, forward_iterator_tag
+#include <utility>  // move, swap
+#include <variant>  // get, get_if, holds_alternative, variant
+#include <vector>  // vector
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // _mm_cmpeq_epi16, _mm_max_epi16, _mm_min_epi16, _mm_movemask_epi8
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>  // _mm_alignr_epi8
+#endif
+
+#include "flat-map.h"
+
+struct RoaringBitmapIterator;
+
+// `roaring_bitmap` is a compressed set of 32-bit unsigned integers
+// (Chambi, Lemire, Kaser, Godin, "Better bitmap performance with Roaring
+// bitmaps", 2016).
+//
+// The 32-bit universe is split into 2^16 chunks by the high 16 bits of each
+// value. Each non-empty chunk holds the low 16 bits of its members in
+// whichever of three containers is smallest:
+//
+//   - an *array container*: a sorted array of up to 4096 `uint16_t`s
+//     (at most 8 KiB);
+//   - a *bitmap container*: 2^16 bits, i.e. exactly 8 KiB;
+//   - a *run container*: a sorted array of [start, start+length] runs,
+//     4 bytes per run.
+//
+// Array and bitmap containers are chosen automatically as chunks grow and
+// shrink. Run containers are produced only by `run_optimize()`, which
+// should be called once a bitmap has been built; modifying a chunk that
+// holds a run container converts it back to an array or bitmap.
+//
+// The chunk index is a `flat_map` from the high 16 bits to the container,
+// so finding a chunk is a binary search over a small contiguous array of keys.
+//
+class roaring_bitmap {
+  public:
+    using value_type = std::uint32_t;
+    using size_type = std::size_t;
+    using iterator = RoaringBitmapIterator;
+    using const_iterator = RoaringBitmapIterator;
+
+    roaring_bitmap() = default;
+
+    template<class InputIt>
+    roaring_bitmap(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            add(*first);
+        }
+    }
+
+    roaring_bitmap(std::initializer_list<std::uint32_t> il) : roaring_bitmap(il.begin(), il.end()) {}
+
+    inline iterator begin() const;
+    inline const_iterator cbegin() const;
+    inline iterator end() const;
+    inline const_iterator cend() const;
+
+    bool empty() const noexcept { return chunks_.empty(); }
+
+    size_type size() const noexcept {
+        size_type n = 0;
+        for (const container& c : chunks_.values()) {
+            n += cardinality(c);
+        }
+        return n;
+    }
+
+    void add(std::uint32_t x) {
+        auto [it, inserted] = chunks_.try_emplace(std::uint16_t(x >> 16));
+        container& c = it->second;
+        if (auto *r = std::get_if<run_container>(&c)) {
+            c = to_array_or_bitmap(to_bitmap(*r));
+        }
+        if (auto *a = std::get_if<array_container>(&c)) {
+            auto pos = std::lower_bound(a->values.begin(), a->values.end(), std::uint16_t(x));
+            if (pos == a->values.end() || *pos != std::uint16_t(x)) {
+                a->values.insert(pos, std::uint16_t(x));
+                if (a->values.size() > array_max) {
+                    c = to_bitmap(*a);
+                }
+            }
+        } else {
+            auto& b = std::get<bitmap_container>(c);
+            std::uint64_t& w = b.words[(x & 0xFFFF) / 64];
+            std::uint64_t m = std::uint64_t(1) << (x % 64);
+            b.cardinality += (w & m) ? 0 : 1;
+            w |= m;
+        }
+    }
+
+    bool remove(std::uint32_t x) {
+        auto it = chunks_.find(std::uint16_t(x >> 16));
+        if (it == chunks_.end()) {
+            return false;
+        }
+        container& c = it->second;
+        if (auto *r = std::get_if<run_container>(&c)) {
+            c = to_array_or_bitmap(to_bitmap(*r));
+        }
+        bool removed = false;
+        if (auto *a = std::get_if<array_container>(&c)) {
+            auto pos = std::lower_bound(a->values.begin(), a->values.end(), std::uint16_t(x));
+            if (pos != a->values.end() && *pos == std::uint16_t(x)) {
+                a->values.erase(pos);
+                removed = true;
+            }
+        } else {
+            auto& b = std::get<bitmap_container>(c);
+            std::uint64_t& w = b.words[(x & 0xFFFF) / 64];
+            std::uint64_t m = std::uint64_t(1) << (x % 64);
+            if (w & m) {
+                w &= ~m;
+                b.cardinality -= 1;
+                removed = true;
+                if (b.cardinality <= array_max) {
+                    c = to_array_or_bitmap(std::move(b));
+                }
+            }
+        }
+        if (cardinality(c) == 0) {
+            chunks_.erase(it);
+        }
+        return removed;
+    }
+
+    bool contains(std::uint32_t x) const {
+        auto it = chunks_.find(std::uint16_t(x >> 16));
+        return it != chunks_.end() && container_contains(it->second, std::uint16_t(x));
+    }
+
+    // Converts each container to a run container if that would be smaller
+    // (or back again if not). Returns true if any chunk now uses runs.
+    //
+    bool run_optimize() {
+        bool any = false;
+        for (auto&& kv : chunks_) {
+            container& c = kv.second;
+            bitmap_container b = to_bitmap(c);
+            std::size_t nruns = count_runs(b);
+            std::size_t card = b.cardinality;
+            std::size_t run_bytes = 2 + 4 * nruns;
+            std::size_t other_bytes = (card <= array_max) ? 2 * card : 8192;
+            if (run_bytes < other_bytes) {
+                c = to_runs(b);
+                any = true;
+            } else {
+                c = to_array_or_bitmap(std::move(b));
+            }
+        }
+        return any;
+    }
+
+    friend roaring_bitmap operator&(const roaring_bitmap& a, const roaring_bitmap& b) {
+        return combine(a, b, false);
+    }
+
+    friend roaring_bitmap operator|(const roaring_bitmap& a, const roaring_bitmap& b) {
+        return combine(a, b, true);
+    }
+
+    roaring_bitmap& operator&=(const roaring_bitmap& rhs) { return *this = *this & rhs; }
+    roaring_bitmap& operator|=(const roaring_bitmap& rhs) { return *this = *this | rhs; }
+
+    // Two bitmaps with the same members are equal even if they store
+    // some chunk in different kinds of container.
+    //
+    friend inline bool operator==(const roaring_bitmap& a, const roaring_bitmap& b);
+
+  private:
+    friend struct RoaringBitmapIterator;
+
+    static constexpr std::size_t array_max = 4096;
+
+    struct array_container {
+        std::vector<std::uint16_t> values;
+    };
+
+    struct bitmap_container {
+        std::vector<std::uint64_t> words = std::vector<std::uint64_t>(1024);
+        std::uint32_t cardinality = 0;
+    };
+
+    // Each run covers the values [start, start + length], inclusive.
+    struct run {
+        std::uint16_t start;
+        std::uint16_t length;
+    };
+
+    struct run_container {
+        std::vector<run> runs;
+    };
+
+    using container = std::variant<array_container, bitmap_container, run_container>;
+
+    static std::size_t cardinality(const container& c) {
+        if (auto *a = std::get_if<array_container>(&c)) {
+            return a->values.size();
+        } else if (auto *b = std::get_if<bitmap_container>(&c)) {
+            return b->cardinality;
+        }
+        std::size_t n = 0;
+        for (run r : std::get<run_container>(c).runs) {
+            n += std::size_t(r.length) + 1;
+        }
+        return n;
+    }
+
+    static bool container_contains(const container& c, std::uint16_t x) {
+        if (auto *a = std::get_if<array_container>(&c)) {
+            return std::binary_search(a->values.begin(), a->values.end(), x);
+        } else if (auto *b = std::get_if<bitmap_container>(&c)) {
+            return (b->words[x / 64] >> (x % 64)) & 1;
+        }
+        const auto& runs = std::get<run_container>(c).runs;
+        auto it = std::upper_bound(runs.begin(), runs.end(), x, [](std::uint16_t v, run r) { return v < r.start; });
+        return it != runs.begin() && x - (it - 1)->start <= (it - 1)->length;
+    }
+
+    static bitmap_container to_bitmap(const array_container& a) {
+        bitmap_container b;
+        for (std::uint16_t v : a.values) {
+            b.words[v / 64] |= std::uint64_t(1) << (v % 64);
+        }
+        b.cardinality = a.values.size();
+        return b;
+    }
+
+    static bitmap_container to_bitmap(const run_container& rc) {
+        bitmap_container b;
+        for (run r : rc.runs) {
+            std::uint32_t first = r.start;
+            std::uint32_t last = first + r.length;
+            for (std::uint32_t w = first / 64; w <= last / 64; ++w) {
+                std::uint32_t lo = std::max(first, w * 64) - w * 64;
+                std::uint32_t hi = std::min(last, w * 64 + 63) - w * 64;
+                b.words[w] |= (~std::uint64_t(0) >> (63 - (hi - lo))) << lo;
+            }
+            b.cardinality += std::uint32_t(r.length) + 1;
+        }
+        return b;
+    }
+
+    static bitmap_container to_bitmap(const container& c) {
+        if (auto *a = std::get_if<array_container>(&c)) {
+            return to_bitmap(*a);
+        } else if (auto *r = std::get_if<run_container>(&c)) {
+            return to_bitmap(*r);
+        }
+        return std::get<bitmap_container>(c);
+    }
+
+    static container to_array_or_bitmap(bitmap_container b) {
+        if (b.cardinality > array_max) {
+            return b;
+        }
+        array_container a;
+        a.values.reserve(b.cardinality);
+        for (std::uint32_t w = 0; w < 1024; ++w) {
+            for (std::uint64_t bits = b.words[w]; bits != 0; bits &= bits - 1) {
+                a.values.push_back(std::uint16_t(w * 64 + std::countr_zero(bits)));
+            }
+        }
+        return a;
+    }
+
+    static std::size_t count_runs(const bitmap_container& b) {
+        // A run starts at every 1 bit whose predecessor is a 0 bit.
+        std::size_t n = 0;
+        std::uint64_t carry = 0;
+        for (std::uint64_t w : b.words) {
+            n += std::popcount(w & ~((w << 1) | carry));
+            carry = w >> 63;
+        }
+        return n;
+    }
+
+    static run_container to_runs(const bitmap_container& b) {
+        run_container rc;
+        std::uint32_t v = next_set_bit(b, 0);
+        while (v != no_cursor) {
+            std::uint32_t end = next_clear_bit(b, v);
+            rc.runs.push_back({std::uint16_t(v), std::uint16_t(end - 1 - v)});
+            v = (end < 65536) ? next_set_bit(b, end) : no_cursor;
+        }
+        return rc;
+    }
+
+    // Intersects two sorted arrays of unique values.
+    //
+    // With SSE2, we compare eight values of `a` against eight values of `b`
+    // at a time: one `_mm_cmpeq_epi16` for each of the eight rotations of b's
+    // block finds every match between the two blocks, and then we advance
+    // whichever block has the smaller maximum (Schlegel, Willhalm, Lehner,
+    // "Fast sorted-set intersection using SIMD instructions", 2011).
+    // When one array is much smaller than the other, we instead gallop
+    // through the larger one.
+    //
+    static void intersect_arrays(const std::vector<std::uint16_t>& av, const std::vector<std::uint16_t>& bv, std::vector<std::uint16_t>& out) {
+        const std::uint16_t *a = av.data();
+        const std::uint16_t *b = bv.data();
+        std::size_t na = av.size();
+        std::size_t nb = bv.size();
+        if (na > nb) {
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+        std::size_t i = 0;
+        std::size_t j = 0;
+        if (na * 32 < nb) {
+            for (; i < na; ++i) {
+                // Gallop to a bound `lo + step` with b[lo + step] >= a[i],
+                // then binary search the bracketed range.
+                std::size_t lo = j;
+                std::size_t step = 1;
+                while (lo + step < nb && b[lo + step] < a[i]) {
+                    lo += step;
+                    step *= 2;
+                }
+                j = std::lower_bound(b + lo, b + std::min(nb, lo + step + 1), a[i]) - b;
+                if (j == nb) {
+                    return;
+                }
+                if (b[j] == a[i]) {
+                    out.push_back(a[i]);
+                    ++j;
+                }
+            }
+            return;
+        }
+#if defined(__SSE2__)
+        while (i + 8 <= na && j + 8 <= nb) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+            __m128i eq = _mm_cmpeq_epi16(va, vb);
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi16(va, rotate<1>(vb)));
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi16(va, rotate<2>(vb)));
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi16(va, rotate<3>(vb)));
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi16(va, rotate<4>(vb)));
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi16(va, rotate<5>(vb)));
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi16(va, rotate<6>(vb)));
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi16(va, rotate<7>(vb)));
+            // movemask yields two identical bits per 16-bit lane.
+            for (unsigned mask = _mm_movemask_epi8(eq) & 0x5555; mask != 0; mask &= mask - 1) {
+                out.push_back(a[i + std::countr_zero(mask) / 2]);
+            }
+            std::uint16_t amax = a[i + 7];
+            std::uint16_t bmax = b[j + 7];
+            i += (amax <= bmax) ? 8 : 0;
+            j += (bmax <= amax) ? 8 : 0;
+        }
+#endif
+        while (i < na && j < nb) {
+            if (a[i] < b[j]) {
+                ++i;
+            } else if (b[j] < a[i]) {
+                ++j;
+            } else {
+                out.push_back(a[i]);
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    // Unites two sorted arrays of unique values.
+    //
+    // With SSSE3, we merge eight values at a time (Inoue, Taura, "SIMD- and
+    // cache-friendly algorithm for sorting an array of structures", 2015,
+    // as used by CRoaring): a merge network of eight min/max steps turns
+    // the eight largest values so far and the next block of eight, from
+    // whichever array's next value is smaller, into the eight smallest of
+    // the sixteen, which are final, and the eight largest, which are kept.
+    // Each value appears at most twice, next to each other, so a compare
+    // with the same block shifted by one lane finds the duplicates to drop.
+    // SSE2 has only signed 16-bit min and max, so values are compared with
+    // their top bit flipped. What's left at the end, fewer than eight values
+    // of one array and possibly many of the other, is merged one at a time.
+    //
+    // Each step of the network rotates a vector by one lane, which takes one
+    // instruction with SSSE3's `_mm_alignr_epi8` but three with plain SSE2,
+    // and then the network is slower than `std::set_union`; so without SSSE3
+    // we use that.
+    //
+    static void unite_arrays(const std::vector<std::uint16_t>& av, const std::vector<std::uint16_t>& bv, std::vector<std::uint16_t>& out) {
+#if defined(__SSSE3__)
+        const std::uint16_t *a = av.data();
+        const std::uint16_t *b = bv.data();
+        std::size_t na = av.size();
+        std::size_t nb = bv.size();
+        if (na >= 8 && nb >= 8) {
+            // Both are array containers, so this is at most 16 KiB.
+            std::uint16_t buf[2 * array_max];
+            std::uint16_t *o = buf;
+            const __m128i flip = _mm_set1_epi16(-0x8000);
+            auto load = [&](const std::uint16_t *p) {
+                return _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), flip);
+            };
+            // Stores the values of `lo` that differ from their predecessor
+            // (`prev`'s last lane, for the first).
+            auto put_unique = [&](__m128i lo, __m128i prev) {
+                __m128i shifted = _mm_or_si128(_mm_slli_si128(lo, 2), _mm_srli_si128(prev, 14));
+                unsigned dup = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi16(lo, shifted)));
+                if (dup == 0) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_xor_si128(lo, flip));
+                    o += 8;
+                    return;
+                }
+                alignas(16) std::uint16_t block[8];
+                _mm_store_si128(reinterpret_cast<__m128i*>(block), _mm_xor_si128(lo, flip));
+                for (unsigned keep = ~dup & 0x5555; keep != 0; keep &= keep - 1) {
+                    *o++ = block[std::countr_zero(keep) / 2];
+                }
+            };
+            auto put = [&](std::uint16_t v) {
+                if (o[-1] != v) {
+                    *o++ = v;
+                }
+            };
+
+            __m128i lo;
+            __m128i hi;
+            merge_blocks(load(a), load(b), lo, hi);
+            std::size_t i = 8;
+            std::size_t j = 8;
+            put_unique(lo, _mm_set1_epi16(std::int16_t(~_mm_extract_epi16(lo, 0))));
+            for (;;) {
+                bool from_a = (j == nb) || (i < na && a[i] <= b[j]);
+                const std::uint16_t *p = from_a ? a + i : b + j;
+                std::size_t& k = from_a ? i : j;
+                if (k + 8 > (from_a ? na : nb)) {
+                    break;
+                }
+                k += 8;
+                __m128i prev = lo;
+                merge_blocks(load(p), hi, lo, hi);
+                put_unique(lo, prev);
+            }
+
+            alignas(16) std::uint16_t rest[8];
+            _mm_store_si128(reinterpret_cast<__m128i*>(rest), _mm_xor_si128(hi, flip));
+            // One of the arrays has fewer than eight values left.
+            const std::uint16_t *s = a + i;
+            const std::uint16_t *se = a + na;
+            const std::uint16_t *l = b + j;
+            const std::uint16_t *le = b + nb;
+            if (na - i > nb - j) {
+                std::swap(s, l);
+                std::swap(se, le);
+            }
+            std::uint16_t small[16];
+            std::uint16_t *smalle = std::set_union(rest, rest + 8, s, se, small);
+            const std::uint16_t *m = small;
+            while (m != smalle && l != le) {
+                put((*m <= *l) ? *m++ : *l++);
+            }
+            for (; m != smalle; ++m) {
+                put(*m);
+            }
+            for (; l != le; ++l) {
+                put(*l);
+            }
+            out.assign(buf, o);
+            return;
+        }
+#endif
+        out.reserve(av.size() + bv.size());
+        std::set_union(av.begin(), av.end(), bv.begin(), bv.end(), std::back_inserter(out));
+    }
+
+#if defined(__SSE2__)
+    template<int K>
+    static __m128i rotate(__m128i v) {
+#if defined(__SSSE3__)
+        return _mm_alignr_epi8(v, v, 2 * K);
+#else
+        return _mm_or_si128(_mm_srli_si128(v, 2 * K), _mm_slli_si128(v, 16 - 2 * K));
+#endif
+    }
+#endif
+
+#if defined(__SSSE3__)
+    // Merges two sorted blocks of eight (signed) values into the sorted
+    // eight smallest, `lo`, and the sorted eight largest, `hi`.
+    //
+    static void merge_blocks(__m128i x, __m128i y, __m128i& lo, __m128i& hi) {
+        __m128i min = _mm_min_epi16(x, y);
+        hi = _mm_max_epi16(x, y);
+        for (int step = 0; step < 7; ++step) {
+            min = rotate<1>(min);
+            __m128i t = min;
+            min = _mm_min_epi16(t, hi);
+            hi = _mm_max_epi16(t, hi);
+        }
+        lo = rotate<1>(min);
+    }
+#endif
+
+    // Computes `a & b` or `a | b` for two containers. Run containers are
+    // expanded to bitmaps first; bitmap-bitmap operations are plain
+    // word-wise loops, which the compiler vectorizes.
+    //
+    static container combine_containers(const container& a, const container& b, bool is_union) {
+        auto *aa = std::get_if<array_container>(&a);
+        auto *ba = std::get_if<array_container>(&b);
+        if (aa && ba) {
+            array_container result;
+            if (is_union) {
+                unite_arrays(aa->values, ba->values, result.values);
+                if (result.values.size() > array_max) {
+                    return to_bitmap(result);
+                }
+            } else {
+                intersect_arrays(aa->values, ba->values, result.values);
+            }
+            return result;
+        }
+        if (!is_union && (aa || ba)) {
+            // Filter the array through the other container's bitmap.
+            const array_container& arr = aa ? *aa : *ba;
+            bitmap_container other = to_bitmap(aa ? b : a);
+            array_container result;
+            for (std::uint16_t v : arr.values) {
+                if ((other.words[v / 64] >> (v % 64)) & 1) {
+                    result.values.push_back(v);
+                }
+            }
+            return result;
+        }
+        bitmap_container x = to_bitmap(a);
+        bitmap_container y = to_bitmap(b);
+        std::uint64_t *px = x.words.data();
+        const std::uint64_t *py = y.words.data();
+        if (is_union) {
+            for (std::size_t i = 0; i < 1024; ++i) {
+                px[i] |= py[i];
+            }
+        } else {
+            for (std::size_t i = 0; i < 1024; ++i) {
+                px[i] &= py[i];
+            }
+        }
+        std::uint32_t card = 0;
+        for (std::size_t i = 0; i < 1024; ++i) {
+            card += std::popcount(px[i]);
+        }
+        x.cardinality = card;
+        return to_array_or_bitmap(std::move(x));
+    }
+
+    // Walks the two sorted chunk indexes in step, like a merge.
+    //
+    static roaring_bitmap combine(const roaring_bitmap& a, const roaring_bitmap& b, bool is_union) {
+        const auto& ak = a.chunks_.keys();
+        const auto& bk = b.chunks_.keys();
+        const auto& ac = a.chunks_.values();
+        const auto& bc = b.chunks_.values();
+        std::vector<std::uint16_t> keys;
+        std::vector<container> values;
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < ak.size() && j < bk.size()) {
+            if (ak[i] < bk[j]) {
+                if (is_union) {
+                    keys.push_back(ak[i]);
+                    values.push_back(ac[i]);
+                }
+                ++i;
+            } else if (bk[j] < ak[i]) {
+                if (is_union) {
+                    keys.push_back(bk[j]);
+                    values.push_back(bc[j]);
+                }
+                ++j;
+            } else {
+                container c = combine_containers(ac[i], bc[j], is_union);
+                if (cardinality(c) != 0) {
+                    keys.push_back(ak[i]);
+                    values.push_back(std::move(c));
+                }
+                ++i;
+                ++j;
+            }
+        }
+        if (is_union) {
+            for (; i < ak.size(); ++i) {
+                keys.push_back(ak[i]);
+                values.push_back(ac[i]);
+            }
+            for (; j < bk.size(); ++j) {
+                keys.push_back(bk[j]);
+                values.push_back(bc[j]);
+            }
+        }
+        roaring_bitmap result;
+        result.chunks_.replace(std::move(keys), std::move(values));
+        return result;
+    }
+
+    // A cursor identifies a position within one container: an index for
+    // array containers, a bit position for bitmap containers, and
+    // (run index << 16 | offset within the run) for run containers.
+    //
+    static constexpr std::uint32_t no_cursor = std::uint32_t(-1);
+
+    static std::uint32_t first_cursor(const container& c) {
+        if (auto *b = std::get_if<bitmap_container>(&c)) {
+            return next_set_bit(*b, 0);
+        }
+        return 0;
+    }
+
+    static std::uint32_t next_cursor(const container& c, std::uint32_t cur) {
+        if (auto *a = std::get_if<array_container>(&c)) {
+            return (cur + 1 < a->values.size()) ? cur + 1 : no_cursor;
+        } else if (auto *b = std::get_if<bitmap_container>(&c)) {
+            return (cur + 1 < 65536) ? next_set_bit(*b, cur + 1) : no_cursor;
+        }
+        const auto& runs = std::get<run_container>(c).runs;
+        std::uint32_t ri = cur >> 16;
+        std::uint32_t off = cur & 0xFFFF;
+        if (off < runs[ri].length) {
+            return cur + 1;
+        }
+        return (ri + 1 < runs.size()) ? (ri + 1) << 16 : no_cursor;
+    }
+
+    static std::uint16_t value_at(const container& c, std::uint32_t cur) {
+        if (auto *a = std::get_if<array_container>(&c)) {
+            return a->values[cur];
+        } else if (std::holds_alternative<bitmap_container>(c)) {
+            return std::uint16_t(cur);
+        }
+        const auto& runs = std::get<run_container>(c).runs;
+        return std::uint16_t(runs[cur >> 16].start + (cur & 0xFFFF));
+    }
+
+    // Returns the position of the first 1 bit at or after `pos`, or `no_cursor`.
+    static std::uint32_t next_set_bit(const bitmap_container& b, std::uint32_t pos) {
+        std::uint32_t w = pos / 64;
+        std::uint64_t bits = b.words[w] & (~std::uint64_t(0) << (pos % 64));
+        while (bits == 0) {
+            if (++w == 1024) {
+                return no_cursor;
+            }
+            bits = b.words[w];
+        }
+        return w * 64 + std::countr_zero(bits);
+    }
+
+    // Returns the position of the first 0 bit at or after `pos`, or 65536.
+    static std::uint32_t next_clear_bit(const bitmap_container& b, std::uint32_t pos) {
+        std::uint32_t w = pos / 64;
+        std::uint64_t bits = ~b.words[w] & (~std::uint64_t(0) << (pos % 64));
+        while (bits == 0) {
+            if (++w == 1024) {
+                return 65536;
+            }
+            bits = ~b.words[w];
+        }
+        return w * 64 + std::countr_zero(bits);
+    }
+
+    flat_map<std::uint16_t, container> chunks_;
+};
+
+// `RoaringBitmapIterator` visits the members of a `roaring_bitmap` in
+// ascending order. It remembers which chunk it's in and a cursor within
+// that chunk's container, plus the current value so that dereferencing
+// is free. A default-constructed iterator is the end iterator.
+//
+struct RoaringBitmapIterator
+{
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::uint32_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::uint32_t;
+
+    RoaringBitmapIterator() {}
+
+    friend class roaring_bitmap;
+  private:
+    explicit RoaringBitmapIterator(const roaring_bitmap *bitmap) : bitmap_(bitmap) {
+        if (bitmap_->chunks_.empty()) {
+            bitmap_ = nullptr;
+        } else {
+            cursor_ = roaring_bitmap::first_cursor(chunk());
+            load();
+        }
+    }
+  public:
+
+    RoaringBitmapIterator(RoaringBitmapIterator const&) = default;
+    RoaringBitmapIterator& operator=(RoaringBitmapIterator const&) = default;
+    RoaringBitmapIterator(RoaringBitmapIterator&&) noexcept = default;
+    RoaringBitmapIterator& operator=(RoaringBitmapIterator&&) = default;
+    ~RoaringBitmapIterator() = default;
+
+    RoaringBitmapIterator operator++(int) {
+        RoaringBitmapIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    RoaringBitmapIterator& operator++() {
+        cursor_ = roaring_bitmap::next_cursor(chunk(), cursor_);
+        if (cursor_ == roaring_bitmap::no_cursor) {
+            if (++chunk_ == bitmap_->chunks_.size()) {
+                *this = RoaringBitmapIterator();
+                return *this;
+            }
+            cursor_ = roaring_bitmap::first_cursor(chunk());
+        }
+        load();
+        return *this;
+    }
+
+    reference operator*() const { return value_; }
+
+    // The `split_advance` customization point (see parallel.h): from the
+    // start of a chunk, skip whole chunks at a time by their cardinality.
+    // Within a chunk, step one value at a time.
+    //
+    friend void split_advance(RoaringBitmapIterator& it, difference_type n) { it.advance(n); }
+
+    friend void swap(RoaringBitmapIterator& a, RoaringBitmapIterator& b) {
+        RoaringBitmapIterator tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    bool operator==(RoaringBitmapIterator const& other) const {
+        return bitmap_ == other.bitmap_ && chunk_ == other.chunk_ && cursor_ == other.cursor_;
+    }
+
+    bool operator!=(RoaringBitmapIterator const& other) const { return !(*this == other); }
+
+  private:
+    void advance(difference_type n) {
+        if (n == 0) {
+            return;
+        }
+        bool at_chunk_start = cursor_ == roaring_bitmap::first_cursor(chunk());
+        while (n != 0) {
+            if (at_chunk_start && std::size_t(n) >= roaring_bitmap::cardinality(chunk())) {
+                n -= difference_type(roaring_bitmap::cardinality(chunk()));
+                if (++chunk_ == bitmap_->chunks_.size()) {
+                    *this = RoaringBitmapIterator();
+                    return;
+                }
+                cursor_ = roaring_bitmap::first_cursor(chunk());
+                load();
+            } else {
+                std::size_t before = chunk_;
+                ++(*this);
+                --n;
+                at_chunk_start = bitmap_ != nullptr && chunk_ != before;
+            }
+        }
+    }
+
+    const roaring_bitmap::container& chunk() const { return bitmap_->chunks_.values()[chunk_]; }
+
+    void load() {
+        std::uint32_t hi = bitmap_->chunks_.keys()[chunk_];
+        value_ = (hi << 16) | roaring_bitmap::value_at(chunk(), cursor_);
+    }
+
+    const roaring_bitmap *bitmap_ = nullptr;
+    std::size_t chunk_ = 0;
+    std::uint32_t cursor_ = 0;
+    std::uint32_t value_ = 0;
+};
+
+inline roaring_bitmap::iterator roaring_bitmap::begin() const { return cbegin(); }
+inline roaring_bitmap::const_iterator roaring_bitmap::cbegin() const { return const_iterator(this); }
+inline roaring_bitmap::iterator roaring_bitmap::end() const { return cend(); }
+inline roaring_bitmap::const_iterator roaring_bitmap::cend() const { return const_iterator(); }
+
+inline bool operator==(const roaring_bitmap& a, const roaring_bitmap& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+static_assert(std::forward_iterator<roaring_bitmap::iterator>);
+static_assert(std::forward_iterator<roaring_bitmap::const_iterator>);
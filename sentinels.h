@@ -0,0 +1,88 @@
+#pragma once
+
+#include <concepts>  // semiregular
+#include <cstddef>  // ptrdiff_t
+#include <iterator>  // counted_iterator, default_sentinel_t, input_iterator, iter_value_t
+#include <utility>  // move
+
+#include "views.h"
+
+// [iterator.concept.sentinel]: Since C++20, the end of a range needn't be
+// an iterator at all, but only a *sentinel*: any semiregular type that can
+// be compared to the range's iterators. `std::sentinel_for<S, I>` checks
+// the requirements. A sentinel lets a range end wherever a condition on
+// the current element first holds, without computing an end iterator ahead
+// of time: for a C string, without a `strlen` pass over the data before the
+// real one.
+//
+// The sentinels here each provide a hidden-friend `operator==` with any
+// input iterator; C++20 synthesizes the reversed and negated comparisons.
+// Use them with `iterator_view` (or `std::ranges::subrange`), e.g.
+//
+//   for (char c : null_terminated(argv[0])) { ... }
+//   for (char c : iterator_view(p, delimiter_sentinel('\n'))) { ... }
+//
+// For a count-down sentinel, use the standard `std::counted_iterator` with
+// `std::default_sentinel`, as `counted` below does.
+//
+
+// `null_sentinel` matches an iterator whose element is equal to a
+// value-initialized `value_type`: '\0' for characters, null for pointers.
+//
+struct null_sentinel_t {
+    template<std::input_iterator It>
+    friend constexpr bool operator==(const It& it, null_sentinel_t) {
+        return *it == std::iter_value_t<It>();
+    }
+};
+
+inline constexpr null_sentinel_t null_sentinel{};
+
+// `delimiter_sentinel(d)` matches an iterator whose element is equal to `d`,
+// e.g. the newline at the end of a record.
+//
+template<class T>
+struct delimiter_sentinel {
+    T delimiter = T();
+
+    template<std::input_iterator It>
+    friend constexpr bool operator==(const It& it, const delimiter_sentinel& s) {
+        return *it == s.delimiter;
+    }
+};
+
+template<class T>
+delimiter_sentinel(T) -> delimiter_sentinel<T>;
+
+// `until_sentinel<Pred>` matches an iterator whose element satisfies `Pred`.
+// Sentinels must be semiregular, so `Pred` must be default-constructible
+// and assignable, as captureless lambdas are in C++20; to stop at a value
+// known only at run time, use `delimiter_sentinel` instead.
+//
+template<std::semiregular Pred>
+struct until_sentinel {
+    [[no_unique_address]] Pred pred = Pred();
+
+    template<std::input_iterator It>
+    friend constexpr bool operator==(const It& it, const until_sentinel& s) {
+        return s.pred(*it);
+    }
+};
+
+template<class Pred>
+until_sentinel(Pred) -> until_sentinel<Pred>;
+
+// Views a null-terminated array, such as a C string, without measuring it.
+//
+template<class T>
+constexpr iterator_view<T*, null_sentinel_t> null_terminated(T *p) {
+    return {p, null_sentinel};
+}
+
+// Views the `n` elements starting at `it`, which needn't be a random-access
+// iterator: the count is decremented as the view is traversed.
+//
+template<std::input_or_output_iterator It>
+constexpr iterator_view<std::counted_iterator<It>, std::default_sentinel_t> counted(It it, std::iter_difference_t<It> n) {
+    return {std::counted_iterator<It>(std::move(it), n), std::default_sentinel};
+}
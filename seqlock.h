@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>  // atomic, memory_order
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <cstring>  // memcpy
+#include <new>  // launder
+#include <type_traits>  // is_trivially_copyable_v
+
+// `seqlock<T>` holds a small, trivially copyable `T` (say, a
+// `ForwardVector<double>` of prices, or a `std::array`) that one writer
+// updates and any number of readers copy out, without locks, and without
+// readers ever writing to memory that other threads read.
+//
+// The writer makes the sequence number odd, stores the new value, and then
+// makes the sequence number even again. A reader reads the sequence number,
+// copies the value, and reads the sequence number again; if the two reads
+// differ, or the first was odd, a write overlapped the copy, and the reader
+// tries again. Readers therefore never see a torn value, and never slow the
+// writer down.
+//
+// A seqlock is usually written with plain (racy) copies of the value and
+// `atomic_thread_fence`s around them. That is a data race as far as the
+// language is concerned, and ThreadSanitizer, which doesn't model fences,
+// reports it. Here, as in Boehm, "Can seqlocks get along with programming
+// language memory models?" (2012), the value is instead stored as an array
+// of word-sized atomics, which the writer stores with `release` and
+// the reader loads with `acquire`. If a reader loads any word of a value
+// that is still being written, it then sees the odd sequence number from
+// before that store, and retries. On x86 these compile to plain moves, just
+// like the racy version.
+//
+// Only one thread may write at a time.
+//
+template<class T>
+class seqlock {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+    using word = std::uint64_t;
+    static constexpr std::size_t words = (sizeof(T) + sizeof(word) - 1) / sizeof(word);
+    static constexpr std::size_t cache_line = 64;
+
+  public:
+    using value_type = T;
+
+    seqlock() noexcept : seqlock(T()) {}
+
+    explicit seqlock(const T& value) noexcept {
+        word w[words] = {};
+        std::memcpy(w, &value, sizeof(T));
+        for (std::size_t i = 0; i < words; ++i) {
+            data_[i].store(w[i], std::memory_order_relaxed);
+        }
+    }
+
+    seqlock(const seqlock&) = delete;
+    seqlock& operator=(const seqlock&) = delete;
+
+    // Called only by the writer.
+    //
+    void store(const T& value) noexcept {
+        word w[words] = {};
+        std::memcpy(w, &value, sizeof(T));
+        std::uint64_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < words; ++i) {
+            data_[i].store(w[i], std::memory_order_release);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Called only by the writer, which can't be racing itself, so its
+    // `load` always succeeds the first time.
+    //
+    template<class F>
+    void update(F&& f) {
+        T value = load();
+        f(value);
+        store(value);
+    }
+
+    // Copies the value, if no write overlaps the copy.
+    //
+    bool try_load(T& out) const noexcept {
+        word w[words];
+        if (!try_copy(w)) {
+            return false;
+        }
+        std::memcpy(&out, w, sizeof(T));
+        return true;
+    }
+
+    // Copies the value, retrying until no write overlaps the copy.
+    //
+    T load() const noexcept {
+        word w[words];
+        while (!try_copy(w)) {
+            cpu_relax();
+        }
+        alignas(T) unsigned char raw[sizeof(T)];
+        std::memcpy(raw, w, sizeof(T));
+        return *std::launder(reinterpret_cast<T*>(raw));
+    }
+
+    // Even when no write is in progress. It changes with every write.
+    //
+    std::uint64_t sequence() const noexcept { return seq_.load(std::memory_order_acquire); }
+
+  private:
+    static void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    bool try_copy(word (&w)[words]) const noexcept {
+        std::uint64_t before = seq_.load(std::memory_order_acquire);
+        if (before & 1) {
+            return false;
+        }
+        for (std::size_t i = 0; i < words; ++i) {
+            w[i] = data_[i].load(std::memory_order_acquire);
+        }
+        return seq_.load(std::memory_order_relaxed) == before;
+    }
+
+    alignas(cache_line) std::atomic<std::uint64_t> seq_ = 0;
+    std::atomic<word> data_[words];
+};
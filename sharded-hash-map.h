@@ -0,0 +1,400 @@
+#pragma once
+
+#include <bit>  // bit_width
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint64_t, uint8_t
+#include <functional>  // equal_to, hash
+#include <iterator>  // forward_iterator, forward_iterator_tag
+#include <memory>  // make_shared, shared_ptr
+#include <mutex>  // lock_guard
+#include <optional>  // optional
+#include <ranges>  // views::iota
+#include <shared_mutex>  // shared_lock, shared_mutex
+#include <tuple>  // forward_as_tuple
+#include <utility>  // as_const, forward, move, pair, piecewise_construct
+#include <vector>  // vector
+
+#include "parallel.h"
+
+template<class Map> struct ShardedHashMapIterator;
+
+// `sharded_hash_map` is a hash map for many threads at once: it is split
+// into `Shards` independent hash tables, each behind its own
+// `std::shared_mutex`, and each key belongs to the shard chosen by the top
+// bits of its (remixed) hash. Threads working on different shards never
+// contend, and with 64 shards, two threads picked at random touch the same
+// one only 1/64 of the time. Each shard occupies its own cache lines, so a
+// lock taken on one doesn't bounce the cache line of its neighbor.
+//
+// Each shard is an open-addressing table with linear probing, as compact
+// and cache-friendly as a flat table can be: a probe walks a byte array of
+// tags (a 7-bit fragment of the hash, plus a bit marking the slot full)
+// and compares keys only where the tag matches. Erasing shifts the rest of
+// the probe run back, rather than leaving a tombstone.
+//
+// There are no iterators into the live tables, since any insertion may
+// rehash a shard. Lookups return copies (`get`) or run a function under the
+// shard's lock (`visit`, `update`). The forward iterator copies one shard at
+// a time, under its shared lock, and walks the copy: each shard it visits
+// is a consistent snapshot, though different shards are snapshotted at
+// different times. `for_each_shard` visits every element in place, one
+// task per shard, in parallel.
+//
+template<class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>, std::size_t Shards = 64>
+class sharded_hash_map {
+    static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "the shard count must be a power of two");
+
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using iterator = ShardedHashMapIterator<sharded_hash_map>;
+    using const_iterator = ShardedHashMapIterator<sharded_hash_map>;
+
+    static constexpr size_type shard_count = Shards;
+
+    sharded_hash_map() = default;
+    explicit sharded_hash_map(const Hash& hash, const KeyEqual& eq = KeyEqual()) : hash_(hash), eq_(eq) {}
+
+    sharded_hash_map(const sharded_hash_map&) = delete;
+    sharded_hash_map& operator=(const sharded_hash_map&) = delete;
+
+    iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(this); }
+    iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(); }
+
+    // Locks each shard in turn, so it's only a snapshot if nobody else is
+    // writing.
+    //
+    size_type size() const {
+        size_type n = 0;
+        for (const shard& s : shards_) {
+            std::shared_lock<std::shared_mutex> lk(s.mutex);
+            n += s.count;
+        }
+        return n;
+    }
+    bool empty() const { return size() == 0; }
+
+    template<class K, class... Args>
+    bool try_emplace(K&& k, Args&&... args) {
+        std::uint64_t h = mix(k);
+        shard& s = shard_for(h);
+        std::lock_guard<std::shared_mutex> lk(s.mutex);
+        if (s.find(k, h, eq_) != npos) {
+            return false;
+        }
+        s.reserve_one(hash_);
+        s.insert_new(h, std::forward<K>(k), std::forward<Args>(args)...);
+        return true;
+    }
+
+    bool insert(const value_type& kv) { return try_emplace(kv.first, kv.second); }
+    bool insert(value_type&& kv) { return try_emplace(std::move(kv.first), std::move(kv.second)); }
+
+    // Returns true if `k` was inserted, false if it was assigned.
+    //
+    template<class M>
+    bool insert_or_assign(const Key& k, M&& obj) {
+        std::uint64_t h = mix(k);
+        shard& s = shard_for(h);
+        std::lock_guard<std::shared_mutex> lk(s.mutex);
+        size_type i = s.find(k, h, eq_);
+        if (i != npos) {
+            s.slots[i]->second = std::forward<M>(obj);
+            return false;
+        }
+        s.reserve_one(hash_);
+        s.insert_new(h, k, std::forward<M>(obj));
+        return true;
+    }
+
+    // Calls `f(value)`, where `value` is the `T&` for `k`, with the shard
+    // locked exclusively. Returns false if there is no such key.
+    //
+    template<class F>
+    bool update(const Key& k, F&& f) {
+        std::uint64_t h = mix(k);
+        shard& s = shard_for(h);
+        std::lock_guard<std::shared_mutex> lk(s.mutex);
+        size_type i = s.find(k, h, eq_);
+        if (i == npos) {
+            return false;
+        }
+        std::forward<F>(f)(s.slots[i]->second);
+        return true;
+    }
+
+    // Calls `f(value)`, where `value` is the `const T&` for `k`, with the
+    // shard locked shared. Returns false if there is no such key.
+    //
+    template<class F>
+    bool visit(const Key& k, F&& f) const {
+        std::uint64_t h = mix(k);
+        const shard& s = shard_for(h);
+        std::shared_lock<std::shared_mutex> lk(s.mutex);
+        size_type i = s.find(k, h, eq_);
+        if (i == npos) {
+            return false;
+        }
+        std::forward<F>(f)(std::as_const(s.slots[i]->second));
+        return true;
+    }
+
+    std::optional<T> get(const Key& k) const {
+        std::optional<T> result;
+        visit(k, [&](const T& v) { result.emplace(v); });
+        return result;
+    }
+
+    bool contains(const Key& k) const { return visit(k, [](const T&) {}); }
+
+    size_type erase(const Key& k) {
+        std::uint64_t h = mix(k);
+        shard& s = shard_for(h);
+        std::lock_guard<std::shared_mutex> lk(s.mutex);
+        size_type i = s.find(k, h, eq_);
+        if (i == npos) {
+            return 0;
+        }
+        s.erase_at(i, hash_);
+        return 1;
+    }
+
+    void clear() {
+        for (shard& s : shards_) {
+            std::lock_guard<std::shared_mutex> lk(s.mutex);
+            s.tags.clear();
+            s.slots.clear();
+            s.count = 0;
+        }
+    }
+
+    // Calls `f(kv)` for every element, with the shards divided among the
+    // workers of `work_stealing_pool::default_pool()`. Each shard is locked
+    // shared while `f` visits its elements, so `f` may run alongside other
+    // readers, but mustn't write to the map.
+    //
+    template<class F>
+    void for_each_shard(F f) const {
+        parallel_for_each(std::views::iota(size_type(0), Shards), [&](size_type i) {
+            const shard& s = shards_[i];
+            std::shared_lock<std::shared_mutex> lk(s.mutex);
+            for (const auto& slot : s.slots) {
+                if (slot) {
+                    f(std::as_const(*slot));
+                }
+            }
+        });
+    }
+
+  private:
+    friend struct ShardedHashMapIterator<sharded_hash_map>;
+
+    static constexpr size_type npos = size_type(-1);
+    static constexpr size_type cache_line = 64;
+    static constexpr unsigned shard_bits = std::bit_width(Shards) - 1;
+
+    // A tag is zero for an empty slot, and otherwise has its top bit set.
+    //
+    static std::uint8_t tag_of(std::uint64_t h) noexcept { return std::uint8_t(0x80 | ((h >> 24) & 0x7f)); }
+
+    // Mixing the hash first means that an identity `std::hash` (as for the
+    // integers) still spreads keys across both the shards and the slots.
+    // The shard comes from the top bits, the slot from the bottom bits.
+    //
+    template<class K>
+    std::uint64_t mix(const K& k) const { return remix(hash_, k); }
+
+    // The stored key isn't `const`, so that erasing can move elements back.
+    //
+    struct alignas(cache_line) shard {
+        mutable std::shared_mutex mutex;
+        std::vector<std::uint8_t> tags;
+        std::vector<std::optional<std::pair<Key, T>>> slots;
+        size_type count = 0;
+
+        size_type mask() const noexcept { return tags.size() - 1; }
+
+        template<class K>
+        size_type find(const K& k, std::uint64_t h, const KeyEqual& eq) const {
+            if (tags.empty()) {
+                return npos;
+            }
+            std::uint8_t tag = tag_of(h);
+            for (size_type i = h & mask(); tags[i] != 0; i = (i + 1) & mask()) {
+                if (tags[i] == tag && eq(slots[i]->first, k)) {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        // Keeps the load factor at most 3/4.
+        //
+        template<class H>
+        void reserve_one(const H& hash) {
+            if (4 * (count + 1) <= 3 * tags.size()) {
+                return;
+            }
+            std::vector<std::uint8_t> old_tags(tags.empty() ? 16 : 2 * tags.size(), 0);
+            std::vector<std::optional<std::pair<Key, T>>> old_slots(old_tags.size());
+            old_tags.swap(tags);
+            old_slots.swap(slots);
+            for (size_type i = 0; i < old_tags.size(); ++i) {
+                if (old_tags[i] != 0) {
+                    size_type j = remix(hash, old_slots[i]->first) & mask();
+                    while (tags[j] != 0) {
+                        j = (j + 1) & mask();
+                    }
+                    tags[j] = old_tags[i];
+                    slots[j] = std::move(old_slots[i]);
+                }
+            }
+        }
+
+        template<class K, class... Args>
+        void insert_new(std::uint64_t h, K&& k, Args&&... args) {
+            size_type i = h & mask();
+            while (tags[i] != 0) {
+                i = (i + 1) & mask();
+            }
+            slots[i].emplace(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(k)),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+            tags[i] = tag_of(h);
+            ++count;
+        }
+
+        // Backward-shift deletion: each later element of the probe run
+        // whose home slot isn't cyclically in (hole, j] moves into the hole.
+        //
+        template<class H>
+        void erase_at(size_type hole, const H& hash) {
+            for (size_type j = (hole + 1) & mask(); tags[j] != 0; j = (j + 1) & mask()) {
+                size_type home = remix(hash, slots[j]->first) & mask();
+                bool stays = (hole < j) ? (hole < home && home <= j) : (hole < home || home <= j);
+                if (!stays) {
+                    tags[hole] = tags[j];
+                    slots[hole] = std::move(slots[j]);
+                    hole = j;
+                }
+            }
+            tags[hole] = 0;
+            slots[hole].reset();
+            --count;
+        }
+    };
+
+    template<class H, class K>
+    static std::uint64_t remix(const H& hash, const K& k) {
+        std::uint64_t h = std::uint64_t(hash(k)) * 0x9e3779b97f4a7c15ULL;
+        return h ^ (h >> 32);
+    }
+
+    shard& shard_for(std::uint64_t h) noexcept { return shards_[shard_index(h)]; }
+    const shard& shard_for(std::uint64_t h) const noexcept { return shards_[shard_index(h)]; }
+
+    static size_type shard_index(std::uint64_t h) noexcept {
+        if constexpr (shard_bits == 0) {
+            return 0;
+        } else {
+            return size_type(h >> (64 - shard_bits));
+        }
+    }
+
+    [[no_unique_address]] Hash hash_ = Hash();
+    [[no_unique_address]] KeyEqual eq_ = KeyEqual();
+    shard shards_[Shards];
+};
+
+// A `ShardedHashMapIterator` holds a copy of the elements of one shard at a
+// time, shared between copies of the iterator. Incrementing past the last
+// element of that shard copies the next nonempty one.
+//
+template<class Map>
+struct ShardedHashMapIterator
+{
+    using iterator_concept = std::forward_iterator_tag;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename Map::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    ShardedHashMapIterator() {}
+
+    friend Map;
+  private:
+    explicit ShardedHashMapIterator(const Map *map) : map_(map) { load(0); }
+  public:
+
+    ShardedHashMapIterator(ShardedHashMapIterator const&) = default;
+    ShardedHashMapIterator& operator=(ShardedHashMapIterator const&) = default;
+    ShardedHashMapIterator(ShardedHashMapIterator&&) noexcept = default;
+    ShardedHashMapIterator& operator=(ShardedHashMapIterator&&) = default;
+    ~ShardedHashMapIterator() = default;
+
+    ShardedHashMapIterator operator++(int) {
+        ShardedHashMapIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    ShardedHashMapIterator& operator++() {
+        if (++pos_ == copy_->size()) {
+            load(shard_ + 1);
+        }
+        return *this;
+    }
+
+    reference operator*() const { return (*copy_)[pos_]; }
+    pointer operator->() const { return &(*copy_)[pos_]; }
+
+    friend void swap(ShardedHashMapIterator& a, ShardedHashMapIterator& b) {
+        ShardedHashMapIterator tmp = std::move(a);
+        a = std::move(b);
+        b = std::move(tmp);
+    }
+
+    bool operator==(ShardedHashMapIterator const& other) const {
+        return map_ == other.map_ && shard_ == other.shard_ && pos_ == other.pos_;
+    }
+
+    bool operator!=(ShardedHashMapIterator const& other) const { return !(*this == other); }
+
+  private:
+    void load(std::size_t first) {
+        for (std::size_t i = first; i < Map::shard_count; ++i) {
+            const auto& s = map_->shards_[i];
+            auto copy = std::make_shared<std::vector<value_type>>();
+            {
+                std::shared_lock<std::shared_mutex> lk(s.mutex);
+                copy->reserve(s.count);
+                for (const auto& slot : s.slots) {
+                    if (slot) {
+                        copy->emplace_back(slot->first, slot->second);
+                    }
+                }
+            }
+            if (!copy->empty()) {
+                copy_ = std::move(copy);
+                shard_ = i;
+                pos_ = 0;
+                return;
+            }
+        }
+        *this = ShardedHashMapIterator();
+    }
+
+    const Map *map_ = nullptr;
+    std::shared_ptr<const std::vector<value_type>> copy_;
+    std::size_t shard_ = 0;
+    std::size_t pos_ = 0;
+};
+
+static_assert(std::forward_iterator<sharded_hash_map<int, int>::iterator>);
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <atomic>  // atomic
+#include <cerrno>  // errno
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint32_t, uint64_t
+#include <limits>  // numeric_limits
+#include <new>  // bad_alloc, bad_array_new_length, operator new
+#include <string>  // string
+#include <system_error>  // errc, generic_category, make_error_code, system_error
+#include <utility>  // exchange, forward, move, swap
+
+#include <fcntl.h>  // O_CREAT, O_EXCL, O_RDWR
+#include <sys/mman.h>  // mmap, munmap, shm_open, shm_unlink
+#include <sys/stat.h>  // fstat
+#include <unistd.h>  // close, ftruncate
+
+#include "offset-ptr.h"
+
+template<class T> class segment_allocator;
+
+// `shared_segment` is a POSIX shared memory object (`shm_open`) mapped into
+// this process, with a simple allocator on top. Containers whose allocator
+// is a `segment_allocator` keep all of their storage inside the segment,
+// and link it together with `offset_ptr`s, so another process can map the
+// same segment (at whatever address) and use those containers in place:
+//
+//   using ivec = std::vector<int, segment_allocator<int>>;
+//
+//   // in the writer
+//   auto seg = shared_segment::create("/ingest", 1 << 30);
+//   ivec *v = seg.construct_root<ivec>(seg.get_allocator<int>());
+//   v->push_back(42);
+//
+//   // in the reader
+//   auto seg = shared_segment::open("/ingest");
+//   ivec *v = seg.root<ivec>();
+//
+// Everything stored in the segment must be address-independent: no raw
+// pointers, no virtual functions, and no `std::allocator`-based members.
+// Processes that use a segment concurrently must synchronize with each
+// other, e.g. through atomics or a process-shared mutex stored in it.
+//
+// Allocation is monotonic: an atomic bump pointer in the segment's header,
+// so any process may allocate. Freeing the most recent allocation gives
+// its space back, but any other freed space is lost until the segment is
+// removed. In particular a growing vector allocates its new buffer before
+// freeing the old one, so every buffer it outgrows stays in the segment:
+// 1000 `push_back`s of `int` use about 8 KiB. Call `reserve` up front
+// where the final size is known. Objects in the segment are never
+// destroyed by `shared_segment`.
+//
+class shared_segment {
+    struct header {
+        std::uint64_t magic;
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::uint64_t size;
+        std::atomic<std::uint64_t> used;
+        offset_ptr<void> root;
+
+        unsigned char *base() noexcept { return reinterpret_cast<unsigned char*>(this); }
+
+        void *allocate(std::size_t bytes, std::size_t align) {
+            std::uint64_t old = used.load(std::memory_order_relaxed);
+            std::uint64_t start;
+            do {
+                start = (old + align - 1) / align * align;
+                if (bytes > size || start > size - bytes) {
+                    throw std::bad_alloc();
+                }
+            } while (!used.compare_exchange_weak(old, start + bytes, std::memory_order_relaxed));
+            return base() + start;
+        }
+
+        void deallocate(void *p, std::size_t bytes) noexcept {
+            std::uint64_t start = static_cast<unsigned char*>(p) - base();
+            std::uint64_t end = start + bytes;
+            used.compare_exchange_strong(end, start, std::memory_order_relaxed);
+        }
+    };
+
+    // [atomics.lockfree]p5: Lock-free atomics are also address-free, which
+    // is what makes it valid to use one from several processes.
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+  public:
+    // Creates a new segment of `bytes` bytes (including a small header).
+    // Fails if a segment named `name` already exists.
+    //
+    static shared_segment create(const std::string& name, std::size_t bytes) {
+        if (bytes < sizeof(header)) {
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "shared_segment: segment is too small");
+        }
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd == -1) {
+            throw_errno("shared_segment: shm_open");
+        }
+        if (::ftruncate(fd, bytes) == -1) {
+            int e = errno;
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::system_error(e, std::generic_category(), "shared_segment: ftruncate");
+        }
+        shared_segment seg(map(fd, bytes), bytes);
+        header *h = ::new (seg.header_) header{0, current_version, 0, bytes, {sizeof(header)}, nullptr};
+        h->magic = magic_number;
+        return seg;
+    }
+
+    // Maps an existing segment, which must have been created (and the
+    // `create` call must have returned) before this is called.
+    //
+    static shared_segment open(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd == -1) {
+            throw_errno("shared_segment: shm_open");
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == -1) {
+            int e = errno;
+            ::close(fd);
+            throw std::system_error(e, std::generic_category(), "shared_segment: fstat");
+        }
+        std::size_t bytes = st.st_size;
+        if (bytes < sizeof(header)) {
+            ::close(fd);
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "shared_segment: segment is too small");
+        }
+        shared_segment seg(map(fd, bytes), bytes);
+        if (seg.header_->magic != magic_number || seg.header_->version != current_version || seg.header_->size != bytes) {
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "shared_segment: bad segment header");
+        }
+        return seg;
+    }
+
+    // Removes the segment's name. It stays mapped in any process that
+    // has already mapped it.
+    //
+    static bool remove(const std::string& name) noexcept { return ::shm_unlink(name.c_str()) == 0; }
+
+    shared_segment(shared_segment&& rhs) noexcept :
+        header_(std::exchange(rhs.header_, nullptr)), bytes_(std::exchange(rhs.bytes_, 0)) {}
+
+    shared_segment& operator=(shared_segment&& rhs) noexcept {
+        shared_segment(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    ~shared_segment() {
+        if (header_ != nullptr) {
+            ::munmap(header_, bytes_);
+        }
+    }
+
+    void swap(shared_segment& rhs) noexcept {
+        using std::swap;
+        swap(header_, rhs.header_);
+        swap(bytes_, rhs.bytes_);
+    }
+
+    friend void swap(shared_segment& a, shared_segment& b) noexcept { a.swap(b); }
+
+    std::size_t size() const noexcept { return bytes_; }
+    std::size_t bytes_used() const noexcept { return header_->used.load(std::memory_order_relaxed); }
+
+    template<class T>
+    segment_allocator<T> get_allocator() const noexcept { return segment_allocator<T>(header_); }
+
+    // Constructs a `T` in the segment and makes it the segment's root object,
+    // the one that `root<T>()` returns in every process.
+    //
+    template<class T, class... Args>
+    T *construct_root(Args&&... args) {
+        T *p = ::new (header_->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        header_->root = static_cast<void*>(p);
+        return p;
+    }
+
+    // Returns the root object, or null if there is none. `T` must be
+    // the type it was constructed with.
+    //
+    template<class T>
+    T *root() const noexcept { return static_cast<T*>(header_->root.get()); }
+
+  private:
+    template<class> friend class segment_allocator;
+
+    static constexpr std::uint64_t magic_number = 0x544e454d'47455348ULL;  // "HSEGMENT" (little-endian)
+    static constexpr std::uint32_t current_version = 1;
+
+    explicit shared_segment(void *base, std::size_t bytes) : header_(static_cast<header*>(base)), bytes_(bytes) {}
+
+    [[noreturn]] static void throw_errno(const char *what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    // Maps and then closes `fd`; the mapping keeps the segment alive.
+    static void *map(int fd, std::size_t bytes) {
+        void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int e = errno;
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            throw std::system_error(e, std::generic_category(), "shared_segment: mmap");
+        }
+        return p;
+    }
+
+    header *header_ = nullptr;
+    std::size_t bytes_ = 0;
+};
+
+// [allocator.requirements.general]: `segment_allocator<T>` allocates from a
+// `shared_segment`, and its `pointer` type is `offset_ptr<T>`. The allocator
+// itself holds only an `offset_ptr` to the segment's header, so a container
+// (and its allocator) can live inside the segment it allocates from.
+//
+// There is no default constructor: get one from `shared_segment::get_allocator`.
+// Two allocators are equal if they allocate from the same segment.
+//
+template<class T>
+class segment_allocator {
+  public:
+    using value_type = T;
+    using pointer = offset_ptr<T>;
+    using const_pointer = offset_ptr<const T>;
+    using void_pointer = offset_ptr<void>;
+    using const_void_pointer = offset_ptr<const void>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    template<class U>
+    segment_allocator(const segment_allocator<U>& rhs) noexcept : header_(rhs.header_) {}
+
+    segment_allocator(const segment_allocator&) noexcept = default;
+    segment_allocator& operator=(const segment_allocator&) noexcept = default;
+
+    pointer allocate(size_type n) {
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return pointer(static_cast<T*>(header_->allocate(n * sizeof(T), alignof(T))));
+    }
+
+    void deallocate(pointer p, size_type n) noexcept { header_->deallocate(p.get(), n * sizeof(T)); }
+
+    friend bool operator==(const segment_allocator& a, const segment_allocator& b) noexcept {
+        return a.header_ == b.header_;
+    }
+
+  private:
+    template<class> friend class segment_allocator;
+    friend class shared_segment;
+
+    explicit segment_allocator(shared_segment::header *h) noexcept : header_(h) {}
+
+    offset_ptr<shared_segment::header> header_;
+};
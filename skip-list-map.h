@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>  // max, min
+#include <atomic>  // atomic, memory_order
+#include <bit>  // countr_zero
+#include <cstddef>  // ptrdiff_t, size_t
+#include <cstdint>  // uint64_t, uintptr_t
+#include <functional>  // less
+#include <iterator>  // bidirectional_iterator, bidirectional_iterator_tag
+#include <memory>  // destroy_at, launder
+#include <new>  // align_val_t, operator new, placement new
+#include <tuple>  // forward_as_tuple
+#include <type_traits>  // conditional_t, is_const_v, remove_cv_t
+#include <utility>  // forward, move, pair, piecewise_construct
+
+#include "reversible-container.h"
+
+template<
+    class QualifiedMap,
+    class UnqualifiedMap = std::remove_cv_t<QualifiedMap>
+> struct SkipListMapIterator;
+
+// `skip_list_map` is an ordered map (Pugh, "Skip lists: a probabilistic
+// alternative to balanced trees", 1990) that any number of threads may
+// insert into, look up, and iterate over at once, without locks.
+//
+// Each node has a tower of `height` forward links, and appears in the sorted
+// list at each of those levels. An insertion finds the node's predecessor
+// and successor at every level, then links it in bottom-up with one
+// `compare_exchange` per level, retrying the search at a level whose links
+// changed meanwhile (as in Herlihy and Shavit, "The Art of Multiprocessor
+// Programming", ch. 14). Linking the bottom level is what makes a node part
+// of the map; the upper levels are only shortcuts for searches.
+//
+// A tower has height `h` with probability `(3/4) * (1/4)^(h-1)`, rather
+// than Pugh's `(1/2)^h`, so there are four times fewer nodes at each level
+// than the one below it. A search then visits slightly more nodes per level
+// but fewer levels, and the top few levels, which every search passes
+// through, are small enough to stay in cache. The head tower is part of the
+// map object itself.
+//
+// The map is insert-only: nodes are never unlinked, so a thread holding a
+// pointer to one needs no reclamation scheme to keep it valid, and
+// iterators stay valid until the map is destroyed. An iterator walks the
+// bottom level, and sees any element inserted ahead of it meanwhile.
+// Decrementing an iterator searches the map for the predecessor of its key,
+// which takes O(log n) time; so does `--end()`.
+//
+// Updates to mapped values are the caller's business: the map hands out
+// plain references to them, as `std::map` does.
+//
+template<class Key, class T, class Compare = std::less<Key>>
+class skip_list_map : public reversible_container<skip_list_map<Key, T, Compare>> {
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using key_compare = Compare;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = SkipListMapIterator<skip_list_map>;
+    using const_iterator = SkipListMapIterator<const skip_list_map>;
+    using reverse_iterator = reverse_iterator_t<iterator>;
+    using const_reverse_iterator = reverse_iterator_t<const_iterator>;
+
+    static constexpr unsigned max_height = 32;
+
+    skip_list_map() = default;
+    explicit skip_list_map(const Compare& comp) : comp_(comp) {}
+
+    skip_list_map(const skip_list_map&) = delete;
+    skip_list_map& operator=(const skip_list_map&) = delete;
+
+    // Not thread-safe.
+    ~skip_list_map() {
+        node *n = head_[0].load(std::memory_order_acquire);
+        while (n != nullptr) {
+            node *next = n->tower()[0].load(std::memory_order_relaxed);
+            destroy_node(n);
+            n = next;
+        }
+    }
+
+    iterator begin() { return iterator(this, head_[0].load(std::memory_order_acquire)); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator cbegin() const { return const_iterator(this, head_[0].load(std::memory_order_acquire)); }
+    iterator end() { return iterator(this, nullptr); }
+    const_iterator end() const { return cend(); }
+    const_iterator cend() const { return const_iterator(this, nullptr); }
+
+    // Exact when no insertion is in progress.
+    size_type size() const noexcept { return size_.load(std::memory_order_relaxed); }
+    bool empty() const noexcept { return head_[0].load(std::memory_order_acquire) == nullptr; }
+
+    key_compare key_comp() const { return comp_; }
+
+    T& operator[](const Key& k) { return try_emplace(k).first->second; }
+    T& operator[](Key&& k) { return try_emplace(std::move(k)).first->second; }
+
+    std::pair<iterator, bool> insert(const value_type& kv) { return try_emplace(kv.first, kv.second); }
+    std::pair<iterator, bool> insert(value_type&& kv) { return try_emplace(std::move(kv.first), std::move(kv.second)); }
+
+    // Thread-safe. If another thread inserts the same key at the same time,
+    // exactly one of them succeeds, and the other gets an iterator to the
+    // winner's element.
+    //
+    template<class K, class... Args>
+    std::pair<iterator, bool> try_emplace(K&& k, Args&&... args) {
+        links preds;
+        node *succs[max_height];
+        if (node *found = search(k, preds, succs)) {
+            return {iterator(this, found), false};
+        }
+        unsigned height = random_height();
+        node *n = make_node(height, std::forward<K>(k), std::forward<Args>(args)...);
+        std::atomic<node*> *tower = n->tower();
+
+        // Linking the bottom level inserts the element. If that fails, some
+        // other node was linked next to the predecessor, perhaps with our key.
+        for (;;) {
+            tower[0].store(succs[0], std::memory_order_relaxed);
+            if (preds[0][0].compare_exchange_strong(succs[0], n, std::memory_order_release, std::memory_order_relaxed)) {
+                break;
+            }
+            if (node *found = search(n->kv.first, preds, succs)) {
+                destroy_node(n);
+                return {iterator(this, found), false};
+            }
+        }
+        size_.fetch_add(1, std::memory_order_relaxed);
+
+        for (unsigned level = 1; level < height; ++level) {
+            for (;;) {
+                tower[level].store(succs[level], std::memory_order_relaxed);
+                if (preds[level][level].compare_exchange_strong(succs[level], n, std::memory_order_release, std::memory_order_relaxed)) {
+                    break;
+                }
+                search(n->kv.first, preds, succs);
+            }
+        }
+        return {iterator(this, n), true};
+    }
+
+    iterator find(const Key& k) { return iterator(this, find_node(k)); }
+    const_iterator find(const Key& k) const { return const_iterator(this, find_node(k)); }
+    bool contains(const Key& k) const { return find_node(k) != nullptr; }
+
+    iterator lower_bound(const Key& k) { return iterator(this, bound(k, false)); }
+    const_iterator lower_bound(const Key& k) const { return const_iterator(this, bound(k, false)); }
+    iterator upper_bound(const Key& k) { return iterator(this, bound(k, true)); }
+    const_iterator upper_bound(const Key& k) const { return const_iterator(this, bound(k, true)); }
+    std::pair<iterator, iterator> equal_range(const Key& k) { return {lower_bound(k), upper_bound(k)}; }
+    std::pair<const_iterator, const_iterator> equal_range(const Key& k) const { return {lower_bound(k), upper_bound(k)}; }
+
+  private:
+    template<class, class> friend struct SkipListMapIterator;
+
+    static constexpr std::size_t cache_line = 64;
+
+    // A node is allocated together with its tower of `height` links, which
+    // follows it in memory.
+    //
+    struct node {
+        template<class K, class... Args>
+        explicit node(unsigned h, K&& k, Args&&... args) :
+            kv(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(k)), std::forward_as_tuple(std::forward<Args>(args)...)),
+            height(h) {}
+
+        std::atomic<node*> *tower() noexcept {
+            return std::launder(reinterpret_cast<std::atomic<node*>*>(reinterpret_cast<unsigned char*>(this) + tower_offset));
+        }
+
+        value_type kv;
+        unsigned height;
+    };
+
+    static constexpr std::size_t tower_align = std::max(alignof(node), alignof(std::atomic<node*>));
+    static constexpr std::size_t tower_offset =
+        (sizeof(node) + alignof(std::atomic<node*>) - 1) / alignof(std::atomic<node*>) * alignof(std::atomic<node*>);
+
+    // `preds[level]` is the tower (possibly `head_`) whose link at `level`
+    // precedes the search key.
+    //
+    using links = std::atomic<node*> *[max_height];
+
+    template<class K, class... Args>
+    static node *make_node(unsigned height, K&& k, Args&&... args) {
+        void *p = ::operator new(tower_offset + height * sizeof(std::atomic<node*>), std::align_val_t(tower_align));
+        node *n;
+        try {
+            n = ::new (p) node(height, std::forward<K>(k), std::forward<Args>(args)...);
+        } catch (...) {
+            ::operator delete(p, std::align_val_t(tower_align));
+            throw;
+        }
+        for (unsigned i = 0; i < height; ++i) {
+            ::new (static_cast<void*>(n->tower() + i)) std::atomic<node*>(nullptr);
+        }
+        return n;
+    }
+
+    static void destroy_node(node *n) noexcept {
+        std::destroy_at(n);
+        ::operator delete(static_cast<void*>(n), std::align_val_t(tower_align));
+    }
+
+    // Each thread draws heights from its own xorshift generator. Two
+    // random bits per level give the 1/4 ratio between levels.
+    //
+    static unsigned random_height() noexcept {
+        thread_local std::uint64_t state = 0;
+        if (state == 0) {
+            state = (std::uint64_t(reinterpret_cast<std::uintptr_t>(&state)) * 0x9e3779b97f4a7c15ULL) | 1;
+        }
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        unsigned h = 1 + unsigned(std::countr_zero(state | (std::uint64_t(1) << 62))) / 2;
+        return std::min(h, max_height);
+    }
+
+    std::atomic<node*> *head_tower() const noexcept { return const_cast<std::atomic<node*>*>(head_); }
+
+    // Fills in `preds` and `succs` at every level for key `k`, and returns
+    // the node with key `k` if there is one.
+    //
+    node *search(const Key& k, links& preds, node *(&succs)[max_height]) const {
+        std::atomic<node*> *pred = head_tower();
+        for (unsigned level = max_height; level-- > 0; ) {
+            node *curr = pred[level].load(std::memory_order_acquire);
+            while (curr != nullptr && comp_(curr->kv.first, k)) {
+                pred = curr->tower();
+                curr = pred[level].load(std::memory_order_acquire);
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        node *n = succs[0];
+        return (n != nullptr && !comp_(k, n->kv.first)) ? n : nullptr;
+    }
+
+    // The first node whose key is not less than `k` (or, if `upper`, is
+    // greater than `k`).
+    //
+    node *bound(const Key& k, bool upper) const {
+        std::atomic<node*> *pred = head_tower();
+        node *curr = nullptr;
+        for (unsigned level = max_height; level-- > 0; ) {
+            curr = pred[level].load(std::memory_order_acquire);
+            while (curr != nullptr && (upper ? !comp_(k, curr->kv.first) : comp_(curr->kv.first, k))) {
+                pred = curr->tower();
+                curr = pred[level].load(std::memory_order_acquire);
+            }
+        }
+        return curr;
+    }
+
+    node *find_node(const Key& k) const {
+        node *n = bound(k, false);
+        return (n != nullptr && !comp_(k, n->kv.first)) ? n : nullptr;
+    }
+
+    // The last node whose key is less than that of `n`, or the last node of
+    // all if `n` is null.
+    //
+    node *predecessor(const node *n) const {
+        std::atomic<node*> *pred = head_tower();
+        node *last = nullptr;
+        for (unsigned level = max_height; level-- > 0; ) {
+            node *curr = pred[level].load(std::memory_order_acquire);
+            while (curr != nullptr && (n == nullptr || comp_(curr->kv.first, n->kv.first))) {
+                last = curr;
+                pred = curr->tower();
+                curr = pred[level].load(std::memory_order_acquire);
+            }
+        }
+        return last;
+    }
+
+    [[no_unique_address]] Compare comp_ = Compare();
+    std::atomic<size_type> size_ = 0;
+    alignas(cache_line) std::atomic<node*> head_[max_height] = {};
+};
+
+template<class QualifiedMap,
+         class UnqualifiedMap /* = std::remove_cv_t<QualifiedMap> */>
+struct SkipListMapIterator
+{
+    using iterator_concept = std::bidirectional_iterator_tag;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename UnqualifiedMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<std::is_const_v<QualifiedMap>, const value_type*, value_type*>;
+    using reference = std::conditional_t<std::is_const_v<QualifiedMap>, const value_type&, value_type&>;
+
+    SkipListMapIterator() {}
+
+    friend UnqualifiedMap;
+    template<class, class> friend struct SkipListMapIterator;
+  private:
+    using node = typename UnqualifiedMap::node;
+
+    explicit SkipListMapIterator(const UnqualifiedMap *map, node *n) : map_(map), node_(n) {}
+  public:
+
+    SkipListMapIterator(SkipListMapIterator const&) = default;
+    SkipListMapIterator& operator=(SkipListMapIterator const&) = default;
+    SkipListMapIterator(SkipListMapIterator&&) noexcept = default;
+    SkipListMapIterator& operator=(SkipListMapIterator&&) = default;
+    ~SkipListMapIterator() = default;
+
+    SkipListMapIterator operator++(int) {
+        SkipListMapIterator tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    SkipListMapIterator operator--(int) {
+        SkipListMapIterator tmp = *this;
+        --(*this);
+        return tmp;
+    }
+
+    SkipListMapIterator& operator++() {
+        node_ = node_->tower()[0].load(std::memory_order_acquire);
+        return *this;
+    }
+
+    SkipListMapIterator& operator--() {
+        node_ = map_->predecessor(node_);
+        return *this;
+    }
+
+    reference operator*() const { return node_->kv; }
+    pointer operator->() const { return &node_->kv; }
+
+    friend void swap(SkipListMapIterator& a, SkipListMapIterator& b) {
+        SkipListMapIterator tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    template<class QM>
+    bool operator==(SkipListMapIterator<QM> const& other) const { return node_ == other.node_; }
+
+    template<class QM>
+    bool operator!=(SkipListMapIterator<QM> const& other) const { return !(*this == other); }
+
+    operator SkipListMapIterator<const UnqualifiedMap>() const {
+        return SkipListMapIterator<const UnqualifiedMap>(map_, node_);
+    }
+
+  private:
+    const UnqualifiedMap *map_ = nullptr;
+    node *node_ = nullptr;
+};
+
+static_assert(std::bidirectional_iterator<skip_list_map<int, int>::iterator>);
+static_assert(std::bidirectional_iterator<skip_list_map<int, int>::const_iterator>);
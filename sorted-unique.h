@@ -0,0 +1,10 @@
+#pragma once
+
+// [flat.map.overview]: Disambiguation tag for constructors and `insert`
+// overloads whose input is already sorted with respect to the container's
+// comparator, and already free of duplicates. Passing a range that doesn't
+// meet that precondition is undefined behavior; in exchange, the container
+// can skip the sort and merge the input in a single linear pass.
+//
+struct sorted_unique_t { explicit sorted_unique_t() = default; };
+inline constexpr sorted_unique_t sorted_unique{};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>  // max, min
+#include <atomic>  // atomic, atomic_thread_fence, memory_order
+#include <cstddef>  // size_t
+#include <cstdint>  // uint32_t, uint64_t
+#include <cstring>  // memcpy
+#include <system_error>  // errc, make_error_code, system_error
+#include <type_traits>  // is_trivially_copyable_v
+
+#if defined(__linux__)
+#include <linux/futex.h>  // FUTEX_WAIT, FUTEX_WAKE
+#include <sys/syscall.h>  // SYS_futex
+#include <unistd.h>  // syscall
+#else
+#include <thread>  // this_thread::yield
+#endif
+
+// `spsc_queue<T, Capacity>` is a fixed-capacity, lock-free ring buffer for
+// exactly one producer and one consumer, which may be in different
+// processes. Like `ForwardVector`, it keeps its elements inline, so the
+// whole queue is one flat object that can be placement-constructed in
+// shared memory (for instance with `shared_segment::construct_root`)
+// and used in place by every process that maps it.
+//
+// To that end it contains no pointers, only address-free (that is,
+// lock-free) 32-bit atomics and indices, and `T` must be trivially
+// copyable; elements are copied in and out with `memcpy`. The queue begins
+// with a header recording a magic number, a layout version, `sizeof(T)`
+// and `Capacity`, which `attach` checks before handing the queue to a
+// process that didn't construct it.
+//
+// The head (next slot to read) and tail (next slot to write) indices are
+// free-running and live on separate cache lines. Each side also keeps a
+// private copy of the other side's index, and only re-reads the shared
+// one when its copy says the queue is full (or empty), so in the steady
+// state neither side touches the other's cache line on every operation.
+//
+// `try_push` and `try_pop` never block. `push` and `pop` block when the
+// queue is full or empty, respectively: they spin briefly, and then, on
+// Linux, sleep on the index itself with a (process-shared) futex. Every
+// operation checks a flag so that it makes a wake-up system call only when
+// the other side is actually asleep. Elsewhere they keep spinning,
+// yielding the processor.
+//
+// Checking that flag safely takes a full fence (an `mfence` on x86) in
+// every `try_push` and `try_pop`, even when nobody ever sleeps; it is most
+// of their cost when the queue is uncontended (see `wake_if_waiting`).
+//
+template<class T, std::size_t Capacity>
+class spsc_queue {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0 && Capacity <= (std::size_t(1) << 31),
+                  "the free-running 32-bit indices require a power-of-two capacity");
+
+    // [atomics.lockfree]p5: Lock-free atomics are also address-free, which
+    // is what makes it valid to use them from several processes.
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    spsc_queue() noexcept {
+        // Publish the header last, so that a concurrent `attach` either
+        // fails or sees a fully constructed queue.
+        magic_.store(magic_number, std::memory_order_release);
+    }
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    // Checks that `p` points to a fully constructed `spsc_queue` of this
+    // exact type, as constructed by another process, and returns it.
+    //
+    static spsc_queue& attach(void *p) {
+        auto *q = static_cast<spsc_queue*>(p);
+        if (q == nullptr || q->magic_.load(std::memory_order_acquire) != magic_number ||
+            q->version_ != current_version || q->value_size_ != sizeof(T) || q->capacity_ != Capacity) {
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "spsc_queue: bad queue header");
+        }
+        return *q;
+    }
+
+    static constexpr size_type capacity() noexcept { return Capacity; }
+
+    // These are exact only when called by the producer or the consumer
+    // while the other side is idle; otherwise they're a snapshot. The head
+    // is read first: the tail read after it can only be ahead of it, so the
+    // difference can't wrap, though by then both sides may have moved on
+    // far enough for it to exceed `Capacity`.
+    //
+    size_type size() const noexcept {
+        std::uint32_t head = head_.load(std::memory_order_acquire);
+        std::uint32_t tail = tail_.load(std::memory_order_acquire);
+        return std::min<size_type>(std::uint32_t(tail - head), Capacity);
+    }
+    bool empty() const noexcept { return size() == 0; }
+
+    // Called only by the producer.
+    //
+    bool try_push(const T& value) noexcept {
+        std::uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - producer_cached_head_ == Capacity) {
+            producer_cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - producer_cached_head_ == Capacity) {
+                return false;
+            }
+        }
+        std::memcpy(slot(tail), &value, sizeof(T));
+        tail_.store(tail + 1, std::memory_order_release);
+        wake_if_waiting(consumer_waiting_, tail_);
+        return true;
+    }
+
+    void push(const T& value) noexcept {
+        for (int spins = 0; !try_push(value); ++spins) {
+            if (spins < spin_limit) {
+                cpu_relax();
+                continue;
+            }
+            wait_while(producer_waiting_, head_, [&](std::uint32_t head) {
+                return tail_.load(std::memory_order_relaxed) - head == Capacity;
+            });
+        }
+    }
+
+    // Called only by the consumer.
+    //
+    bool try_pop(T& out) noexcept {
+        std::uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head == consumer_cached_tail_) {
+            consumer_cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == consumer_cached_tail_) {
+                return false;
+            }
+        }
+        std::memcpy(&out, slot(head), sizeof(T));
+        head_.store(head + 1, std::memory_order_release);
+        wake_if_waiting(producer_waiting_, head_);
+        return true;
+    }
+
+    void pop(T& out) noexcept {
+        for (int spins = 0; !try_pop(out); ++spins) {
+            if (spins < spin_limit) {
+                cpu_relax();
+                continue;
+            }
+            wait_while(consumer_waiting_, tail_, [&](std::uint32_t tail) {
+                return head_.load(std::memory_order_relaxed) == tail;
+            });
+        }
+    }
+
+  private:
+    static constexpr std::uint64_t magic_number = 0x474e4952'43535053ULL;  // "SPSCRING" (little-endian)
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::size_t cache_line = 64;
+
+    // How many times `push` and `pop` retry before going to sleep. A
+    // handoff between two busy cores takes well under a microsecond, much
+    // less than a futex round trip.
+    static constexpr int spin_limit = 256;
+
+    static void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    unsigned char *slot(std::uint32_t i) noexcept { return data_ + (i % Capacity) * sizeof(T); }
+
+    // The waiter sets its flag and then re-checks the index; the waker
+    // updates the index and then checks the flag. With a sequentially
+    // consistent fence between each store and the following load, at least
+    // one of them sees the other's store, so no wake-up is lost. The futex
+    // itself also re-checks that the index is still `observed` before
+    // sleeping.
+    //
+    template<class Pred>
+    static void wait_while(std::atomic<std::uint32_t>& flag, std::atomic<std::uint32_t>& index, Pred still_blocked) noexcept {
+        flag.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint32_t observed = index.load(std::memory_order_relaxed);
+        if (still_blocked(observed)) {
+            futex_wait(index, observed);
+        }
+    }
+
+    // The fence is the expensive part of a `try_push` or `try_pop`: a
+    // round trip through an empty queue takes about 20 ns with it and about
+    // 4 ns without it. It can't be skipped when the queue wasn't empty (or
+    // full) at the start of the operation: the other side may catch up,
+    // find the queue empty (or full), set its flag, and go to sleep while
+    // our store of the index is still in this core's store buffer, and with
+    // no fence our load of the flag can be satisfied before that store
+    // becomes visible. A queue used only through `try_push` and `try_pop`
+    // pays for this anyway.
+    //
+    static void wake_if_waiting(std::atomic<std::uint32_t>& flag, std::atomic<std::uint32_t>& index) noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (flag.load(std::memory_order_relaxed) != 0) {
+            flag.store(0, std::memory_order_relaxed);
+            futex_wake(index);
+        }
+    }
+
+    static void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept {
+#if defined(__linux__)
+        // Not FUTEX_WAIT_PRIVATE: the other side may be in another process.
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+#else
+        (void)word;
+        (void)expected;
+        std::this_thread::yield();
+#endif
+    }
+
+    static void futex_wake(std::atomic<std::uint32_t>& word) noexcept {
+#if defined(__linux__)
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+        (void)word;
+#endif
+    }
+
+    std::atomic<std::uint64_t> magic_ = 0;
+    std::uint32_t version_ = current_version;
+    std::uint32_t value_size_ = sizeof(T);
+    std::uint64_t capacity_ = Capacity;
+
+    // The consumer's cache line: the index it advances, the flag the producer
+    // sets before sleeping on that index, and the consumer's copy of `tail_`.
+    alignas(cache_line) std::atomic<std::uint32_t> head_ = 0;
+    std::atomic<std::uint32_t> producer_waiting_ = 0;
+    std::uint32_t consumer_cached_tail_ = 0;
+
+    // The producer's cache line, likewise.
+    alignas(cache_line) std::atomic<std::uint32_t> tail_ = 0;
+    std::atomic<std::uint32_t> consumer_waiting_ = 0;
+    std::uint32_t producer_cached_head_ = 0;
+
+    alignas(std::max(cache_line, alignof(T))) unsigned char data_[Capacity * sizeof(T)];
+};
@@ -0,0 +1,119 @@
+// The checks are `assert`s, so keep them even in a build with `-DNDEBUG`.
+#undef NDEBUG
+
+#include <array>  // array
+#include <atomic>  // atomic
+#include <bit>  // bit_cast
+#include <cassert>  // assert
+#include <cstdio>  // puts
+#include <thread>  // thread
+#include <type_traits>  // is_trivially_copyable_v
+#include <vector>  // vector
+
+#include "forward-iterator.h"
+#include "seqlock.h"
+
+// A stress test of `seqlock`: one writer stores values whose fields all
+// equal the same counter, while several readers check that every value
+// they load is consistent and that the counter never goes backwards. Build
+// it from the top of the repository, and run it, with
+//
+//   c++ -std=c++20 -O1 -g -fsanitize=thread -pthread -I. test/seqlock.cpp && ./a.out
+//
+// ThreadSanitizer should report nothing: the seqlock's reads and writes are
+// all atomic. (Also try `-fsanitize=address,undefined`.)
+//
+
+struct top_of_book {
+    double bid;
+    double ask;
+    long bid_size;
+    long ask_size;
+    char symbol[5];
+};
+
+static_assert(std::is_trivially_copyable_v<ForwardVector<long>>);
+
+static void stress_array() {
+    constexpr long writes = 200'000;
+    constexpr int readers = 4;
+    seqlock<std::array<long, 10>> s;
+    std::atomic<bool> done = false;
+
+    std::vector<std::thread> ts;
+    for (int r = 0; r < readers; ++r) {
+        ts.emplace_back([&] {
+            long last = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                std::array<long, 10> a = s.load();
+                for (long x : a) {
+                    assert(x == a[0]);
+                }
+                assert(a[0] >= last);
+                last = a[0];
+                std::array<long, 10> b;
+                if (s.try_load(b)) {
+                    for (long x : b) {
+                        assert(x == b[0]);
+                    }
+                    assert(b[0] >= last);
+                    last = b[0];
+                }
+            }
+        });
+    }
+    for (long i = 1; i <= writes; ++i) {
+        std::array<long, 10> a;
+        a.fill(i);
+        s.store(a);
+    }
+    done = true;
+    for (std::thread& t : ts) {
+        t.join();
+    }
+    assert(s.load()[9] == writes);
+    assert(s.sequence() == 2 * writes);
+}
+
+static void stress_struct() {
+    constexpr long writes = 100'000;
+    seqlock<top_of_book> s(top_of_book{0, 1, 0, 0, "ABCD"});
+    std::atomic<bool> done = false;
+
+    std::thread reader([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            top_of_book b = s.load();
+            assert(b.ask == b.bid + 1 && b.bid_size == long(b.bid) && b.ask_size == b.bid_size);
+            assert(b.symbol[0] == 'A' && b.symbol[4] == '\0');
+        }
+    });
+    for (long i = 1; i <= writes; ++i) {
+        s.update([&](top_of_book& b) {
+            b.bid = double(i);
+            b.ask = double(i) + 1;
+            b.bid_size = i;
+            b.ask_size = i;
+        });
+    }
+    done = true;
+    reader.join();
+    assert(s.load().bid_size == writes);
+}
+
+// `ForwardVector` has no element access beyond its (skeleton) iterators,
+// so fill it and check it through the array it wraps.
+//
+static void forward_vector() {
+    std::array<long, 10> a = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    seqlock<ForwardVector<long>> s;
+    s.store(std::bit_cast<ForwardVector<long>>(a));
+    assert((std::bit_cast<std::array<long, 10>>(s.load()) == a));
+    assert(s.sequence() == 2);
+}
+
+int main() {
+    stress_array();
+    stress_struct();
+    forward_vector();
+    std::puts("ok");
+}
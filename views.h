@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cassert>  // assert
+#include <concepts>  // same_as
+#include <cstddef>  // ptrdiff_t, size_t
+#include <iterator>  // bidirectional_iterator, forward_iterator, input_or_output_iterator, iter_difference_t, next, prev, sentinel_for, sized_sentinel_for
+#include <ranges>  // contiguous_range, data, enable_borrowed_range, enable_view, range_reference_t, size, sized_range
+#include <type_traits>  // is_convertible_v, is_same_v, is_trivially_copyable_v, remove_cv_t, remove_cvref_t, remove_reference_t
+#include <utility>  // move
+
+// `contiguous_view<T>` and `iterator_view<It, Sent>` are non-owning views
+// of (part of) a container: the moral equivalents of `std::span<T>` and
+// `std::ranges::subrange<It, Sent>`, for passing a range to a function by
+// value instead of passing the whole container by reference.
+//
+// Both are trivially copyable (given trivially copyable iterators), so at
+// two words apiece they're passed in registers. Neither owns its elements,
+// so both are borrowed ranges: iterators obtained from a view remain valid
+// after the view itself is gone, as long as the container lives.
+//
+// `first(n)`, `last(n)` and `subview(offset, count)` slice a view into a
+// smaller view of the same kind. They're O(1) for `contiguous_view`, and
+// O(n) for an `iterator_view` over non-random-access iterators.
+//
+// Use `as_view(c)` to get the appropriate view of a whole container.
+//
+
+// A pointer and a size.
+//
+template<class T>
+class contiguous_view {
+  public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+    using iterator = T*;
+
+    constexpr contiguous_view() noexcept = default;
+    constexpr contiguous_view(T *data, size_type size) noexcept : data_(data), size_(size) {}
+    constexpr contiguous_view(T *first, T *last) noexcept : data_(first), size_(last - first) {}
+
+    // Views a contiguous, sized container, such as `mapped_vector`.
+    //
+    template<class C>
+        requires (!std::is_same_v<std::remove_cvref_t<C>, contiguous_view> &&
+                  std::ranges::contiguous_range<C&> && std::ranges::sized_range<C&> &&
+                  std::is_convertible_v<std::remove_reference_t<std::ranges::range_reference_t<C&>>(*)[], T(*)[]>)
+    constexpr contiguous_view(C& c) : data_(std::ranges::data(c)), size_(std::ranges::size(c)) {}
+
+    // `contiguous_view<T>` converts to `contiguous_view<const T>`.
+    //
+    template<class U>
+        requires std::is_convertible_v<U(*)[], T(*)[]>
+    constexpr contiguous_view(const contiguous_view<U>& rhs) noexcept : data_(rhs.data()), size_(rhs.size()) {}
+
+    constexpr iterator begin() const noexcept { return data_; }
+    constexpr iterator end() const noexcept { return data_ + size_; }
+
+    constexpr T *data() const noexcept { return data_; }
+    constexpr size_type size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    constexpr T& operator[](size_type i) const { assert(i < size_); return data_[i]; }
+    constexpr T& front() const { assert(size_ != 0); return data_[0]; }
+    constexpr T& back() const { assert(size_ != 0); return data_[size_ - 1]; }
+
+    constexpr contiguous_view first(size_type n) const { assert(n <= size_); return {data_, n}; }
+    constexpr contiguous_view last(size_type n) const { assert(n <= size_); return {data_ + (size_ - n), n}; }
+    constexpr contiguous_view subview(size_type offset, size_type count) const {
+        assert(offset <= size_ && count <= size_ - offset);
+        return {data_ + offset, count};
+    }
+    constexpr contiguous_view subview(size_type offset) const { return subview(offset, size_ - offset); }
+
+  private:
+    T *data_ = nullptr;
+    size_type size_ = 0;
+};
+
+// An iterator and a sentinel. `size()` is available only when the sentinel
+// can be subtracted from the iterator in O(1), and `back()` and `last(n)`
+// only for bidirectional iterators whose sentinel is another iterator.
+//
+template<std::input_or_output_iterator It, std::sentinel_for<It> Sent = It>
+class iterator_view {
+  public:
+    using iterator = It;
+    using sentinel = Sent;
+    using size_type = std::size_t;
+    using difference_type = std::iter_difference_t<It>;
+
+    constexpr iterator_view() = default;
+    constexpr iterator_view(It first, Sent last) : first_(std::move(first)), last_(std::move(last)) {}
+
+    constexpr It begin() const { return first_; }
+    constexpr Sent end() const { return last_; }
+
+    constexpr bool empty() const { return first_ == last_; }
+
+    constexpr size_type size() const requires std::sized_sentinel_for<Sent, It> {
+        return static_cast<size_type>(last_ - first_);
+    }
+
+    constexpr decltype(auto) front() const { assert(!empty()); return *first_; }
+    constexpr decltype(auto) back() const
+        requires std::bidirectional_iterator<It> && std::same_as<It, Sent>
+    {
+        assert(!empty());
+        return *std::prev(last_);
+    }
+
+    constexpr iterator_view<It> first(size_type n) const requires std::forward_iterator<It> {
+        return {first_, std::next(first_, difference_type(n))};
+    }
+    constexpr iterator_view last(size_type n) const
+        requires std::bidirectional_iterator<It> && std::same_as<It, Sent>
+    {
+        return {std::prev(last_, difference_type(n)), last_};
+    }
+    constexpr iterator_view<It> subview(size_type offset, size_type count) const requires std::forward_iterator<It> {
+        It b = std::next(first_, difference_type(offset));
+        return {b, std::next(b, difference_type(count))};
+    }
+    constexpr iterator_view subview(size_type offset) const requires std::forward_iterator<It> {
+        return {std::next(first_, difference_type(offset)), last_};
+    }
+
+  private:
+    [[no_unique_address]] It first_ = It();
+    [[no_unique_address]] Sent last_ = Sent();
+};
+
+template<class It, class Sent>
+iterator_view(It, Sent) -> iterator_view<It, Sent>;
+
+template<std::ranges::contiguous_range C>
+contiguous_view(C&) -> contiguous_view<std::remove_reference_t<std::ranges::range_reference_t<C&>>>;
+
+template<class T>
+inline constexpr bool std::ranges::enable_borrowed_range<contiguous_view<T>> = true;
+
+template<class T>
+inline constexpr bool std::ranges::enable_view<contiguous_view<T>> = true;
+
+template<class It, class Sent>
+inline constexpr bool std::ranges::enable_borrowed_range<iterator_view<It, Sent>> = true;
+
+template<class It, class Sent>
+inline constexpr bool std::ranges::enable_view<iterator_view<It, Sent>> = true;
+
+// Returns a `contiguous_view` of `c` if it is a contiguous range of known
+// size, and an `iterator_view` of `c.begin()` and `c.end()` otherwise.
+// (Having `data()` and `size()` isn't enough: `dynamic_bitset::data()`
+// returns its words, while `size()` counts its bits.)
+//
+template<class C>
+constexpr auto as_view(C& c) {
+    if constexpr (std::ranges::contiguous_range<C&> && std::ranges::sized_range<C&>) {
+        return contiguous_view(c);
+    } else {
+        return iterator_view(c.begin(), c.end());
+    }
+}
+
+static_assert(std::is_trivially_copyable_v<contiguous_view<int>>);
+static_assert(std::is_trivially_copyable_v<iterator_view<int*>>);
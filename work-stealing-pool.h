@@ -0,0 +1,399 @@
+#pragma once
+
+#include <atomic>  // atomic, atomic_thread_fence, memory_order
+#include <cassert>  // assert
+#include <condition_variable>  // condition_variable
+#include <cstddef>  // size_t
+#include <cstdint>  // int64_t, uint64_t
+#include <deque>  // deque
+#include <exception>  // current_exception, exception_ptr, rethrow_exception
+#include <memory>  // make_unique, unique_ptr
+#include <mutex>  // lock_guard, mutex, unique_lock
+#include <thread>  // jthread, thread, this_thread::yield
+#include <type_traits>  // is_trivially_copyable_v
+#include <utility>  // move
+#include <vector>  // vector
+
+// `chase_lev_deque<T>` is the work-stealing deque of Chase and Lev,
+// "Dynamic circular work-stealing deque" (SPAA 2005), with the memory
+// orderings of Lê et al., "Correct and efficient work-stealing for weak
+// memory models" (PPoPP 2013).
+//
+// Its owner pushes and pops at the bottom, like a stack, without any
+// read-modify-write operations except when the deque is down to its last
+// element. Any other thread may steal from the top. The circular buffer
+// doubles when it fills up; the old buffers are kept until the deque is
+// destroyed, because a concurrent thief may still be reading from one.
+//
+// `T` must be trivially copyable (in practice, a pointer).
+//
+template<class T>
+class chase_lev_deque {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    struct ring {
+        explicit ring(std::int64_t capacity) :
+            mask(capacity - 1), slots(std::make_unique<std::atomic<T>[]>(capacity)) {}
+
+        std::int64_t capacity() const noexcept { return mask + 1; }
+        T get(std::int64_t i) const noexcept { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, T x) noexcept { slots[i & mask].store(x, std::memory_order_relaxed); }
+
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    static constexpr std::size_t cache_line = 64;
+
+  public:
+    explicit chase_lev_deque(std::int64_t capacity = 256) {
+        assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+        rings_.push_back(std::make_unique<ring>(capacity));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+
+    chase_lev_deque(const chase_lev_deque&) = delete;
+    chase_lev_deque& operator=(const chase_lev_deque&) = delete;
+
+    // Called only by the owner.
+    //
+    void push(T x) {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        ring *a = ring_.load(std::memory_order_relaxed);
+        if (b - t > a->capacity() - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, x);
+        // Lê et al. use a release fence and a relaxed store here. A release
+        // store is as cheap (a plain store on x86), and ThreadSanitizer,
+        // which doesn't model fences, can see that it publishes the task.
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    // Called only by the owner. Returns false if the deque is empty
+    // (or a thief got to its last element first).
+    //
+    bool pop(T& out) noexcept {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        ring *a = ring_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = a->get(b);
+        if (t == b) {
+            // The last element: race any thieves for it.
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // May be called by any thread. Returns false if the deque is empty
+    // or another thread won the race for its top element.
+    //
+    bool steal(T& out) noexcept {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        ring *a = ring_.load(std::memory_order_acquire);
+        T x = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        out = x;
+        return true;
+    }
+
+    // A snapshot, which may be stale by the time it returns.
+    bool empty() const noexcept {
+        return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    ring *grow(ring *a, std::int64_t t, std::int64_t b) {
+        auto bigger = std::make_unique<ring>(a->capacity() * 2);
+        for (std::int64_t i = t; i < b; ++i) {
+            bigger->put(i, a->get(i));
+        }
+        rings_.push_back(std::move(bigger));
+        ring_.store(rings_.back().get(), std::memory_order_release);
+        return rings_.back().get();
+    }
+
+    alignas(cache_line) std::atomic<std::int64_t> top_ = 0;
+    alignas(cache_line) std::atomic<std::int64_t> bottom_ = 0;
+    std::atomic<ring*> ring_ = nullptr;
+    std::vector<std::unique_ptr<ring>> rings_;  // owner only
+};
+
+// `work_stealing_pool` is a fixed set of worker threads, each with its own
+// `chase_lev_deque` of tasks, for fork-join parallelism:
+//
+//   work_stealing_pool& pool = work_stealing_pool::default_pool();
+//   pool.fork_join([&] { left(); }, [&] { right(); });
+//
+// `fork_join(f, g)` pushes `g` onto the calling worker's deque, runs `f`,
+// and then pops `g` back and runs it too, unless an idle worker has stolen
+// it in the meantime. In that case the caller doesn't block: while it
+// waits for `g` to finish, it runs other tasks, from its own deque or
+// stolen from a random victim's. Tasks are allocated on the forking
+// thread's stack, so a fork costs no allocation, no lock and (unless the
+// task is stolen) no read-modify-write.
+//
+// Called from a thread that isn't one of the pool's workers, `fork_join`
+// and `run` hand the work to a worker through a shared queue and block
+// until it's done. An exception thrown by either task is rethrown by
+// `fork_join` after both have finished.
+//
+// Idle workers spin briefly and then sleep (with `std::atomic::wait`),
+// to be woken when a task is pushed.
+//
+class work_stealing_pool {
+    struct task {
+        void (*invoke)(task*) = nullptr;
+        std::atomic<bool> done = false;
+        bool external = false;
+        std::exception_ptr error;
+    };
+
+    template<class F>
+    struct task_for : task {
+        explicit task_for(F& f) : fn(f) {
+            this->invoke = [](task *t) { static_cast<task_for*>(t)->fn(); };
+        }
+        F& fn;
+    };
+
+    struct worker {
+        chase_lev_deque<task*> deque;
+        std::uint64_t rng = 0;
+    };
+
+    // How many times an idle worker looks for work before going to sleep.
+    static constexpr int spin_limit = 64;
+
+  public:
+    explicit work_stealing_pool(unsigned threads = std::thread::hardware_concurrency()) {
+        if (threads == 0) {
+            threads = 1;
+        }
+        workers_.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i) {
+            workers_.push_back(std::make_unique<worker>());
+            workers_.back()->rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+        }
+        threads_.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i) {
+            threads_.emplace_back([this, i] { worker_main(i); });
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    // The pool must have no outstanding work when it's destroyed.
+    ~work_stealing_pool() {
+        stop_.store(true, std::memory_order_relaxed);
+        work_epoch_.fetch_add(1, std::memory_order_seq_cst);
+        work_epoch_.notify_all();
+        threads_.clear();
+    }
+
+    // A pool with one worker per hardware thread, created on first use.
+    static work_stealing_pool& default_pool() {
+        static work_stealing_pool pool;
+        return pool;
+    }
+
+    unsigned concurrency() const noexcept { return unsigned(workers_.size()); }
+
+    // True if the calling thread is one of this pool's workers.
+    bool on_worker() const noexcept { return current_pool_ == this; }
+
+    // Runs `f()` on one of the workers, so that it may fork, and blocks the
+    // calling thread until it's done. On a worker, just calls `f()`.
+    //
+    template<class F>
+    void run(F&& f) {
+        if (on_worker()) {
+            f();
+            return;
+        }
+        task_for<F> t(f);
+        t.external = true;
+        {
+            std::lock_guard<std::mutex> lk(inject_mutex_);
+            injected_.push_back(&t);
+            injected_size_.fetch_add(1, std::memory_order_relaxed);
+        }
+        signal_work();
+        {
+            std::unique_lock<std::mutex> lk(inject_mutex_);
+            external_done_.wait(lk, [&] { return t.done.load(std::memory_order_relaxed); });
+        }
+        if (t.error) {
+            std::rethrow_exception(t.error);
+        }
+    }
+
+    // Runs `f()` and `g()`, possibly in parallel, and returns when both
+    // are done.
+    //
+    template<class F, class G>
+    void fork_join(F&& f, G&& g) {
+        if (!on_worker()) {
+            run([&] { fork_join(f, g); });
+            return;
+        }
+        worker& w = *workers_[current_index_];
+        task_for<G> t(g);
+        w.deque.push(&t);
+        signal_work();
+
+        std::exception_ptr error;
+        try {
+            f();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        // Whatever `f` forked, it also joined, so `t` is on the bottom of our
+        // deque unless it was stolen. Thieves take the oldest task first, so
+        // if `t` was stolen, so was everything beneath it, and `pop` fails.
+        //
+        task *popped;
+        if (w.deque.pop(popped)) {
+            assert(popped == &t);
+            execute(popped);
+        } else {
+            while (!t.done.load(std::memory_order_acquire)) {
+                if (task *other = find_task(current_index_)) {
+                    execute(other);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        if (t.error) {
+            std::rethrow_exception(t.error);
+        }
+    }
+
+  private:
+    // Once `done` is set, the task's owner may return and free it, so we
+    // mustn't touch the task after that. A thread blocked in `run` waits on
+    // the pool's own condition variable rather than on anything in the task.
+    //
+    void execute(task *t) {
+        try {
+            t->invoke(t);
+        } catch (...) {
+            t->error = std::current_exception();
+        }
+        if (t->external) {
+            std::lock_guard<std::mutex> lk(inject_mutex_);
+            t->done.store(true, std::memory_order_relaxed);
+            external_done_.notify_all();
+        } else {
+            t->done.store(true, std::memory_order_release);
+        }
+    }
+
+    void worker_main(unsigned i) {
+        current_pool_ = this;
+        current_index_ = i;
+        int idle = 0;
+        while (!stop_.load(std::memory_order_relaxed)) {
+            if (task *t = find_task(i)) {
+                execute(t);
+                idle = 0;
+            } else if (++idle < spin_limit) {
+                std::this_thread::yield();
+            } else {
+                sleep_until_work(i);
+                idle = 0;
+            }
+        }
+    }
+
+    task *find_task(unsigned i) {
+        worker& w = *workers_[i];
+        task *t;
+        if (w.deque.pop(t)) {
+            return t;
+        }
+        if (injected_size_.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard<std::mutex> lk(inject_mutex_);
+            if (!injected_.empty()) {
+                t = injected_.front();
+                injected_.pop_front();
+                injected_size_.fetch_sub(1, std::memory_order_relaxed);
+                return t;
+            }
+        }
+        // xorshift64, to pick where to start looking for a victim.
+        w.rng ^= w.rng << 13;
+        w.rng ^= w.rng >> 7;
+        w.rng ^= w.rng << 17;
+        std::size_t n = workers_.size();
+        std::size_t start = w.rng % n;
+        for (std::size_t k = 0; k < n; ++k) {
+            std::size_t v = (start + k) % n;
+            if (v != i && workers_[v]->deque.steal(t)) {
+                return t;
+            }
+        }
+        return nullptr;
+    }
+
+    // Every push bumps `work_epoch_` before checking for sleepers. A worker
+    // going to sleep reads the epoch, announces itself, looks for work one
+    // last time, and sleeps only if the epoch hasn't moved since; so either
+    // it sees the new work, or the pusher sees it and wakes it.
+    //
+    void sleep_until_work(unsigned i) {
+        std::uint64_t epoch = work_epoch_.load(std::memory_order_seq_cst);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        if (task *t = find_task(i)) {
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            execute(t);
+            return;
+        }
+        if (!stop_.load(std::memory_order_relaxed)) {
+            work_epoch_.wait(epoch, std::memory_order_seq_cst);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void signal_work() {
+        work_epoch_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) != 0) {
+            work_epoch_.notify_one();
+        }
+    }
+
+    static inline thread_local const work_stealing_pool *current_pool_ = nullptr;
+    static inline thread_local unsigned current_index_ = 0;
+
+    std::vector<std::unique_ptr<worker>> workers_;
+    std::mutex inject_mutex_;
+    std::deque<task*> injected_;
+    std::condition_variable external_done_;
+    std::atomic<std::size_t> injected_size_ = 0;
+    std::atomic<std::uint64_t> work_epoch_ = 0;
+    std::atomic<unsigned> sleepers_ = 0;
+    std::atomic<bool> stop_ = false;
+    std::vector<std::jthread> threads_;  // last, so the workers stop first
+};